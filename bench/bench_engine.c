@@ -0,0 +1,354 @@
+/*
+ * Created by Sean Bowers
+ * CS 2060 section 3, Spring 2018
+ * University of Colorado at Colorado Springs
+ *
+ * Licensed under the MIT License (see LICENSE.txt)
+ */
+/* Engine microbenchmarks
+ * Times the engine's hot functions one at a time. Every benchmark is warmed up, then the
+ * number of iterations is doubled until a batch takes at least --mintime, and that batch
+ * is timed --samples times. The median (and fastest) time per operation is reported, along
+ * with throughput in the items each operation works on (cells, characters, colors...).
+ *
+ * Usage (from the root of the repository, so ./assets/ can be found):
+ *  bench_engine [--filter=TEXT] [--samples=N] [--mintime=MS] [--output=FILE]
+ * --filter: only run benchmarks with TEXT in their name
+ * --samples: timed batches per benchmark (default 7)
+ * --mintime: shortest a timed batch can be, in milliseconds (default 10)
+ * --output: file the results are written to as JSON (default bench_engine.json)
+ */
+
+#include <engine.h>
+#include <xpFunctions.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Benchmarks */
+typedef struct Benchmark_s{
+    char name[64];
+    // runs the operation being timed iterations times
+    void (*run)(void* data, int iterations);
+    void* data;
+    // number of items (and what they are) one operation works on, for throughput
+    double itemsPerOperation;
+    const char* items;
+} Benchmark;
+
+typedef struct BenchmarkResult_s{
+    int iterations; // per batch
+    double medianNs, fastestNs; // per operation
+} BenchmarkResult;
+
+static BenchmarkResult runBenchmark(Benchmark* benchmark);
+static int compareDoubles(const void* a, const void* b);
+
+/* Settings */
+static int numSamples = 7;
+static int minBatchTime = 10000; // us
+
+/* Benchmark state */
+static Engine* engine;
+// results are added to this, so the compiler can't throw the work away
+static volatile uint32_t sink;
+
+// colors and color pairs used by the color benchmarks
+#define PALETTE_SIZE 64
+static int paletteColors[PALETTE_SIZE][3];
+
+// every asset shipped with the game
+static const char* assetNames[] = {
+    "Alcubierre", "Alcubierre_Title", "Alcubierre_Title1", "Alcubierre_Title2", "Alcubierre_Title3",
+    "Alcubierre_Title4", "Alcubierre_Title5", "Alcubierre_Title6", "Alcubierre_Title7", "Alcubierre_Title8",
+    "Alcubierre_Title9", "Alcubierre_Title10", "Alcubierre_Title11", "BaseMissionScreen", "EnemyBase",
+    "Loading1", "Loading2", "Loading3", "Loading4", "Location_Completed", "Location_Current",
+    "Location_Current1", "Location_Current2", "Location_Skipped", "Location_Unknown", "Overview",
+    "PlayerShip", "Static1", "Static2", "Static3", "Static_Hack1", "Static_Hack2", "Static_Hack3",
+    "Static_Hack4", "Static_Hack5",
+};
+#define NUM_ASSETS (int)(sizeof(assetNames) / sizeof(char*))
+
+typedef struct AssetData_s{
+    char path[128];
+    XPFile* file;
+    CursesChar* buffer; // layer sized
+} AssetData;
+
+/* Benchmark functions */
+// Colors
+static void benchmarkBestColorCold(void* data, int iterations){
+    for (int i = 0; i < iterations; i++){
+        // starting from the standard colors, every color is a new one
+        resetColors(engine);
+        for (int color = 0; color < PALETTE_SIZE; color++){
+            sink += getBestColor(paletteColors[color][0], paletteColors[color][1], paletteColors[color][2], engine);
+        }
+    }
+}
+
+static void benchmarkBestColorWarm(void* data, int iterations){
+    for (int i = 0; i < iterations; i++){
+        // every color was made by fillPalette()
+        for (int color = 0; color < PALETTE_SIZE; color++){
+            sink += getBestColor(paletteColors[color][0], paletteColors[color][1], paletteColors[color][2], engine);
+        }
+    }
+}
+
+static void benchmarkColorPairCold(void* data, int iterations){
+    for (int i = 0; i < iterations; i++){
+        resetColors(engine);
+        for (int pair = 0; pair < PALETTE_SIZE; pair++){
+            sink += getColorPair(pair % 16, (pair / 16) % 16, engine);
+        }
+    }
+}
+
+static void benchmarkColorPairWarm(void* data, int iterations){
+    for (int i = 0; i < iterations; i++){
+        for (int pair = 0; pair < PALETTE_SIZE; pair++){
+            sink += getColorPair(pair % 16, (pair / 16) % 16, engine);
+        }
+    }
+}
+
+// Makes every color and color pair used above, so the warm benchmarks find them
+static void fillPalette(){
+    resetColors(engine);
+    for (int color = 0; color < PALETTE_SIZE; color++){
+        getBestColor(paletteColors[color][0], paletteColors[color][1], paletteColors[color][2], engine);
+    }
+    for (int pair = 0; pair < PALETTE_SIZE; pair++){
+        getColorPair(pair % 16, (pair / 16) % 16, engine);
+    }
+}
+
+// CP437 conversion
+static void benchmarkCP437(void* data, int iterations){
+    for (int i = 0; i < iterations; i++){
+        for (int value = 0; value < 256; value++){
+            sink += getUTF8CharForCP437Value(value);
+        }
+    }
+}
+
+// xp files
+static void benchmarkDrawLayer(void* data, int iterations){
+    AssetData* asset = (AssetData*)data;
+    for (int i = 0; i < iterations; i++){
+        for (int layer = 0; layer < asset->file->numLayers; layer++){
+            drawLayerToBuffer(&asset->file->layers[layer], asset->buffer, (layer > 0), engine);
+        }
+        sink += asset->buffer[0].glyph;
+    }
+}
+
+static void benchmarkGetXPFile(void* data, int iterations){
+    AssetData* asset = (AssetData*)data;
+    for (int i = 0; i < iterations; i++){
+        XPFile* file = getXPFile(asset->path);
+        sink += file->numLayers;
+        freeXPFile(file);
+    }
+}
+
+// Buffers
+static CursesChar* frameBuffer;
+
+static void benchmarkPrintfShort(void* data, int iterations){
+    for (int i = 0; i < iterations; i++){
+        sink += bufferPrintf(frameBuffer, 60, BUFFER_STRIDE, 1, 0, 0, 0, "FPS: %.2f | Raster: %.3fms", 98.5f + (i & 1), 0.25f);
+    }
+}
+
+static const char* longText = "Scout Sector for Resistance [Done] - the resistance fleet has gathered at the edge of the sector, "
+    "and is waiting for word from the Alcubierre before it moves in. Every base the aliens hold between here and the "
+    "stargate has to be cleared first, or the fleet will be cut off before it can reach the gate. Engines are charged, "
+    "shields are up, and the weapons are ready. The crew is waiting on your orders, captain. %d";
+
+static void benchmarkPrintfLong(void* data, int iterations){
+    for (int i = 0; i < iterations; i++){
+        sink += bufferPrintf(frameBuffer, 80, BUFFER_STRIDE, 16, 0, 0, 0, longText, i);
+    }
+}
+
+static void benchmarkWritechar(void* data, int iterations){
+    CursesChar ch = {getGlyph(L'#'), getCellStyle(A_BOLD)};
+    for (int i = 0; i < iterations; i++){
+        for (int y = 0; y < engine->height; y++){
+            for (int x = 0; x < engine->width; x++){
+                writecharToBuffer(frameBuffer, x, y, &ch);
+            }
+        }
+        sink += frameBuffer[i % engine->width].glyph;
+    }
+}
+
+int main(int argc, char* argv[]){
+    const char* outputPath = "bench_engine.json";
+    const char* filter = NULL;
+
+    /* Read args */
+    for (int i = 1; i < argc; i++){
+        if ((strncmp(argv[i], "--filter=", 9) == 0)){
+            filter = argv[i] + 9;
+        } else if ((strncmp(argv[i], "--samples=", 10) == 0)){
+            numSamples = atoi(argv[i] + 10);
+        } else if ((strncmp(argv[i], "--mintime=", 10) == 0)){
+            minBatchTime = atoi(argv[i] + 10) * 1000;
+        } else if ((strncmp(argv[i], "--output=", 9) == 0)){
+            outputPath = argv[i] + 9;
+        } else {
+            printf("Unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (numSamples < 1){
+        numSamples = 1;
+    }
+
+    FILE* output = fopen(outputPath, "w");
+    if (output == NULL){
+        printf("Could not open %s to write results to.\n", outputPath);
+        return 1;
+    }
+
+    /* Start the engine */
+    // the headless backend sets up curses (for colors) without a terminal
+    // nothing is drawn, so keep the render threads out of the way
+    engine = initializeEngineWithBackend(256, 72, createHeadlessBackend(NULL, NULL, 1000));
+    lockThreadLock(&engine->renderThreadData.dataLock);
+    engine->renderThreadData.renderReady = true;
+    broadcastConditionSignal(&engine->renderThreadData.engineRenderReady);
+    unlockThreadLock(&engine->renderThreadData.dataLock);
+
+    frameBuffer = (CursesChar*) allocateAlignedBuffer(engine->stdscrBufferSize);
+    memcpy(frameBuffer, engine->backgroundBuffer, engine->stdscrBufferSize);
+
+    // spread the palette over the color cube, so none of the colors match each other
+    for (int color = 0; color < PALETTE_SIZE; color++){
+        paletteColors[color][0] = 40 + ((color % 4) * 60);
+        paletteColors[color][1] = 40 + (((color / 4) % 4) * 60);
+        paletteColors[color][2] = 40 + ((color / 16) * 60);
+    }
+
+    /* Set up benchmarks */
+    int maxBenchmarks = 8 + (NUM_ASSETS * 2);
+    Benchmark* benchmarks = (Benchmark*) calloc(maxBenchmarks, sizeof(Benchmark));
+    AssetData* assets = (AssetData*) calloc(NUM_ASSETS, sizeof(AssetData));
+    int numBenchmarks = 0;
+    Benchmark* benchmark;
+
+    #define ADD_BENCHMARK(benchmarkName, function, benchmarkData, perOperation, itemName)\
+        benchmark = &benchmarks[numBenchmarks++];\
+        snprintf(benchmark->name, sizeof(benchmark->name), "%s", benchmarkName);\
+        benchmark->run = function;\
+        benchmark->data = benchmarkData;\
+        benchmark->itemsPerOperation = perOperation;\
+        benchmark->items = itemName
+
+    ADD_BENCHMARK("getBestColor/cold", benchmarkBestColorCold, NULL, PALETTE_SIZE, "colors");
+    ADD_BENCHMARK("getBestColor/warm", benchmarkBestColorWarm, NULL, PALETTE_SIZE, "colors");
+    ADD_BENCHMARK("getColorPair/cold", benchmarkColorPairCold, NULL, PALETTE_SIZE, "pairs");
+    ADD_BENCHMARK("getColorPair/warm", benchmarkColorPairWarm, NULL, PALETTE_SIZE, "pairs");
+    ADD_BENCHMARK("getUTF8CharForCP437Value", benchmarkCP437, NULL, 256, "chars");
+    ADD_BENCHMARK("bufferPrintf/short", benchmarkPrintfShort, NULL, 27, "chars");
+    ADD_BENCHMARK("bufferPrintf/long", benchmarkPrintfLong, NULL, strlen(longText), "chars");
+    ADD_BENCHMARK("writecharToBuffer", benchmarkWritechar, NULL, engine->width * engine->height, "cells");
+    for (int i = 0; i < NUM_ASSETS; i++){
+        AssetData* asset = &assets[i];
+        snprintf(asset->path, sizeof(asset->path), "./assets/%s.xp", assetNames[i]);
+        asset->file = getXPFile(asset->path);
+        if (asset->file == NULL){
+            printf("Could not load %s (bench_engine should be run from the root of the repository)\n", asset->path);
+            return 1;
+        }
+        int cells = asset->file->layers[0].width * asset->file->layers[0].height;
+        asset->buffer = (CursesChar*) malloc(sizeof(CursesChar) * cells);
+
+        char name[64];
+        snprintf(name, sizeof(name), "drawLayerToBuffer/%s", assetNames[i]);
+        ADD_BENCHMARK(name, benchmarkDrawLayer, asset, cells * asset->file->numLayers, "cells");
+        snprintf(name, sizeof(name), "getXPFile/%s", assetNames[i]);
+        ADD_BENCHMARK(name, benchmarkGetXPFile, asset, cells * asset->file->numLayers, "cells");
+    }
+    #undef ADD_BENCHMARK
+
+    /* Run benchmarks */
+    fprintf(output, "{\n  \"samples\": %d,\n  \"minBatchTimeUs\": %d,\n  \"benchmarks\": [", numSamples, minBatchTime);
+    printf("%-40s %12s %12s %12s %16s\n", "benchmark", "iterations", "median(ns)", "fastest(ns)", "throughput");
+    bool first = true;
+    for (int i = 0; i < numBenchmarks; i++){
+        benchmark = &benchmarks[i];
+        if (filter != NULL && strstr(benchmark->name, filter) == NULL){
+            continue;
+        }
+
+        // the warm color benchmarks need the palette filled, and everything else should see it the same way
+        fillPalette();
+        BenchmarkResult result = runBenchmark(benchmark);
+        double operationsPerSecond = 1000000000.0 / result.medianNs;
+        double itemsPerSecond = operationsPerSecond * benchmark->itemsPerOperation;
+
+        printf("%-40s %12d %12.1f %12.1f %10.2fM %s/s\n", benchmark->name, result.iterations, result.medianNs, result.fastestNs,
+                itemsPerSecond / 1000000.0, benchmark->items);
+        fprintf(output, "%s\n    {\"name\": \"%s\", \"iterations\": %d, \"medianNs\": %.2f, \"fastestNs\": %.2f, "
+                "\"operationsPerSecond\": %.1f, \"itemsPerSecond\": %.1f, \"items\": \"%s\"}",
+                (first)? "" : ",", benchmark->name, result.iterations, result.medianNs, result.fastestNs,
+                operationsPerSecond, itemsPerSecond, benchmark->items);
+        first = false;
+    }
+    fprintf(output, "\n  ]\n}\n");
+    fclose(output);
+
+    /* Clean up */
+    for (int i = 0; i < NUM_ASSETS; i++){
+        freeXPFile(assets[i].file);
+        free(assets[i].buffer);
+    }
+    free(assets);
+    free(benchmarks);
+    freeAlignedBuffer(frameBuffer);
+    destroyEngine(engine);
+
+    return 0;
+}
+
+/* Timing */
+static BenchmarkResult runBenchmark(Benchmark* benchmark){
+    BenchmarkResult result;
+
+    /* Warm up, and find how many iterations fill a batch */
+    benchmark->run(benchmark->data, 1);
+    int iterations = 1;
+    while (true){
+        uint64_t start = getTimeus();
+        benchmark->run(benchmark->data, iterations);
+        if (getTimeus() - start >= (uint64_t)minBatchTime || iterations >= (1 << 30)){
+            break;
+        }
+        iterations *= 2;
+    }
+    result.iterations = iterations;
+
+    /* Time batches */
+    double* samples = (double*) malloc(sizeof(double) * numSamples);
+    for (int sample = 0; sample < numSamples; sample++){
+        uint64_t start = getTimeus();
+        benchmark->run(benchmark->data, iterations);
+        samples[sample] = ((double)(getTimeus() - start) * 1000.0) / iterations;
+    }
+    qsort(samples, numSamples, sizeof(double), compareDoubles);
+    result.medianNs = samples[numSamples / 2];
+    result.fastestNs = samples[0];
+    free(samples);
+
+    return result;
+}
+
+static int compareDoubles(const void* a, const void* b){
+    double valueA = *(const double*)a;
+    double valueB = *(const double*)b;
+    return (valueA > valueB) - (valueA < valueB);
+}
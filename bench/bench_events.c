@@ -0,0 +1,400 @@
+/*
+ * Created by Sean Bowers
+ * CS 2060 section 3, Spring 2018
+ * University of Colorado at Colorado Springs
+ *
+ * Licensed under the MIT License (see LICENSE.txt)
+ */
+/* Event benchmark
+ * Sends events through engine->handleEvent() from one or more producer threads, and measures
+ * how fast they make it through the event thread (eventThreadFunction) and the active panel's
+ * listeners (defaultPanelHandleEvent). Each event is timestamped right before it's queued, and
+ * its latency is taken when the panel has finished dispatching it. Every combination of producer
+ * count, listener count, and mask mix is run, on the headless backend so no terminal is needed.
+ *
+ * Since events only go through engine->handleEvent() and the active panel, a different queue can
+ * be compared by swapping in its handleEvent() (and event thread) and running this again.
+ *
+ * Usage:
+ *  bench_events [--events=N] [--producers=N] [--listeners=N,N,...] [--mix=NAME] [--rate=N] [--output=FILE]
+ * --events: events sent in each run, split between the producers (default 200000)
+ * --producers: most producer threads to run with - runs start at 1 and double up to N (default 4)
+ * --listeners: listener counts to run with (default 1,8,64)
+ * --mix: only run the mask mix with this name (keyboard, mixed, or broadcast)
+ * --rate: events per second sent by each producer (default 0 - as fast as possible). Unlimited runs
+ *         measure throughput, but their latency includes the backlog in the queue; set a rate to
+ *         measure the latency of a queue that's keeping up.
+ * --output: file the results are written to as JSON (default bench_events.json)
+ */
+
+#include <engine.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* Events */
+// events are freed by the event thread, so the timestamp lives in the same allocation
+typedef struct BenchEvent_s{
+    Event event; // must be first
+    uint64_t queuedTime; // getTimens()
+} BenchEvent;
+
+typedef struct BenchListener_s{
+    Object objectProperties;
+    uint64_t received;
+} BenchListener;
+
+/* Mask mixes */
+#define MAX_MIX_TYPES 8
+
+typedef struct MaskMix_s{
+    const char* name;
+    // producers cycle through these event types
+    unsigned int eventTypes[MAX_MIX_TYPES];
+    int numEventTypes;
+    // listeners are given these masks in turn
+    unsigned int listenerMasks[MAX_MIX_TYPES];
+    int numListenerMasks;
+} MaskMix;
+
+#define NUM_MIXES 3
+static MaskMix mixes[NUM_MIXES];
+static void setupMaskMixes();
+
+/* Settings */
+static int eventsPerRun = 200000;
+static int maxProducers = 4;
+static int listenerCounts[16] = {1, 8, 64};
+static int numListenerCounts = 3;
+static int producerRate = 0;
+
+/* Run state */
+static Engine* engine;
+
+static struct BenchRun_s{
+    MaskMix* mix;
+    int numProducers;
+    int totalEvents;
+
+    // written by the event thread only
+    uint64_t* latencies;
+    int dispatched;
+
+    // signaled by the event thread once every event has been dispatched
+    ThreadLock_t lock;
+    ThreadCondition_t finished;
+    bool done;
+    uint64_t startTime, endTime;
+
+    // all producers wait here, so they start at the same time
+    ThreadBarrier_t startBarrier;
+} run;
+
+typedef struct Producer_s{
+    Thread_t thread;
+    int firstEvent, numEvents;
+    uint64_t enqueueTime; // total time spent in engine->handleEvent()
+} Producer;
+
+static int producerThreadFunction(void* data);
+
+// the panel's default handleEvent(), which benchPanelHandleEvent() wraps
+static void (*dispatchPanelEvent)(Object* self, Event* event);
+static void benchPanelHandleEvent(Object* self, Event* event);
+static void benchListenerHandleEvent(Object* self, Event* event);
+
+/* Results */
+typedef struct LatencySummary_s{
+    double mean, p50, p90, p99, p999, max;
+} LatencySummary;
+
+static int compareLatencies(const void* a, const void* b);
+static LatencySummary summarizeLatencies(uint64_t* latencies, int count);
+
+int main(int argc, char* argv[]){
+    const char* outputPath = "bench_events.json";
+    const char* onlyMix = NULL;
+
+    /* Read args */
+    for (int i = 1; i < argc; i++){
+        if ((strncmp(argv[i], "--events=", 9) == 0)){
+            eventsPerRun = atoi(argv[i] + 9);
+        } else if ((strncmp(argv[i], "--producers=", 12) == 0)){
+            maxProducers = atoi(argv[i] + 12);
+        } else if ((strncmp(argv[i], "--listeners=", 12) == 0)){
+            numListenerCounts = 0;
+            char* count = argv[i] + 12;
+            while (*count != '\0' && numListenerCounts < 16){
+                listenerCounts[numListenerCounts++] = atoi(count);
+                count += strcspn(count, ",");
+                count += (*count == ',');
+            }
+        } else if ((strncmp(argv[i], "--mix=", 6) == 0)){
+            onlyMix = argv[i] + 6;
+        } else if ((strncmp(argv[i], "--rate=", 7) == 0)){
+            producerRate = atoi(argv[i] + 7);
+        } else if ((strncmp(argv[i], "--output=", 9) == 0)){
+            outputPath = argv[i] + 9;
+        } else {
+            printf("Unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (eventsPerRun < 1 || maxProducers < 1 || numListenerCounts < 1){
+        printf("--events, --producers, and --listeners must be at least 1\n");
+        return 1;
+    }
+
+    FILE* output = fopen(outputPath, "w");
+    if (output == NULL){
+        printf("Could not open %s to write results to.\n", outputPath);
+        return 1;
+    }
+
+    setupMaskMixes();
+
+    /* Start the engine */
+    // nothing is drawn, so keep the render threads out of the way
+    engine = initializeEngineWithBackend(80, 24, createHeadlessBackend(NULL, NULL, 1000));
+    lockThreadLock(&engine->renderThreadData.dataLock);
+    engine->renderThreadData.renderReady = true;
+    broadcastConditionSignal(&engine->renderThreadData.engineRenderReady);
+    unlockThreadLock(&engine->renderThreadData.dataLock);
+
+    createLock(&run.lock);
+    createConditionVariable(&run.finished);
+    run.latencies = (uint64_t*) malloc(sizeof(uint64_t) * eventsPerRun);
+
+    /* Run every combination */
+    fprintf(output, "{\n  \"eventsPerRun\": %d,\n  \"producerRate\": %d,\n  \"runs\": [", eventsPerRun, producerRate);
+    printf("%-10s %9s %9s %12s %12s %11s %10s %10s %10s %10s\n", "mix", "producers", "listeners", "events/s",
+            "deliveries/s", "enqueue(ns)", "p50(us)", "p90(us)", "p99(us)", "max(us)");
+    bool first = true;
+    for (int mixIndex = 0; mixIndex < NUM_MIXES; mixIndex++){
+        MaskMix* mix = &mixes[mixIndex];
+        if (onlyMix != NULL && strcmp(onlyMix, mix->name) != 0){
+            continue;
+        }
+
+        for (int listenerIndex = 0; listenerIndex < numListenerCounts; listenerIndex++){
+            int numListeners = listenerCounts[listenerIndex];
+            // 1, 2, 4... producers, always ending with maxProducers
+            for (int numProducers = 1; ; numProducers *= 2){
+                if (numProducers > maxProducers){
+                    numProducers = maxProducers;
+                }
+
+                /* Set up the panel receiving events */
+                Panel* panel = createPanel(1, 1, 0, 0, 0);
+                dispatchPanelEvent = panel->objectProperties.handleEvent;
+                panel->objectProperties.handleEvent = benchPanelHandleEvent;
+                BenchListener* listeners = (BenchListener*) calloc(numListeners, sizeof(BenchListener));
+                for (int i = 0; i < numListeners; i++){
+                    listeners[i].objectProperties.handleEvent = benchListenerHandleEvent;
+                    EventTypeMask mask;
+                    mask.mask = mix->listenerMasks[i % mix->numListenerMasks];
+                    panel->registerEventListener(panel, mask, (Object*)&listeners[i]);
+                }
+
+                lockThreadLock(&engine->eventThreadData.dataLock);
+                engine->activePanel = panel;
+                unlockThreadLock(&engine->eventThreadData.dataLock);
+
+                /* Run */
+                run.mix = mix;
+                run.numProducers = numProducers;
+                run.totalEvents = eventsPerRun;
+                run.dispatched = 0;
+                run.done = false;
+                createBarrier(&run.startBarrier, numProducers + 1);
+
+                Producer* producers = (Producer*) calloc(numProducers, sizeof(Producer));
+                for (int i = 0; i < numProducers; i++){
+                    producers[i].firstEvent = (eventsPerRun * i) / numProducers;
+                    producers[i].numEvents = ((eventsPerRun * (i + 1)) / numProducers) - producers[i].firstEvent;
+                    createThread(&producers[i].thread, (ThreadProcess_t)producerThreadFunction, &producers[i]);
+                }
+                run.startTime = getTimens();
+                enterThreadBarrier(&run.startBarrier);
+
+                lockThreadLock(&run.lock);
+                while (!run.done){
+                    waitForConditionSignal(&run.finished, &run.lock);
+                }
+                unlockThreadLock(&run.lock);
+
+                uint64_t enqueueTime = 0;
+                for (int i = 0; i < numProducers; i++){
+                    joinThread(&producers[i].thread);
+                    enqueueTime += producers[i].enqueueTime;
+                }
+                free(producers);
+                destroyBarrier(&run.startBarrier);
+
+                lockThreadLock(&engine->eventThreadData.dataLock);
+                engine->activePanel = engine->mainPanel;
+                unlockThreadLock(&engine->eventThreadData.dataLock);
+
+                /* Report */
+                uint64_t deliveries = 0;
+                for (int i = 0; i < numListeners; i++){
+                    deliveries += listeners[i].received;
+                }
+                destroyPanel(panel);
+                free(listeners);
+
+                double seconds = (run.endTime - run.startTime) / 1.0e9;
+                double eventsPerSecond = eventsPerRun / seconds;
+                double deliveriesPerSecond = deliveries / seconds;
+                double enqueueNs = (double)enqueueTime / eventsPerRun;
+                LatencySummary latency = summarizeLatencies(run.latencies, eventsPerRun);
+
+                printf("%-10s %9d %9d %12.0f %12.0f %11.1f %10.2f %10.2f %10.2f %10.2f\n", mix->name, numProducers,
+                        numListeners, eventsPerSecond, deliveriesPerSecond, enqueueNs, latency.p50 / 1000.0,
+                        latency.p90 / 1000.0, latency.p99 / 1000.0, latency.max / 1000.0);
+                fprintf(output, "%s\n    {\"mix\": \"%s\", \"producers\": %d, \"listeners\": %d, \"seconds\": %.6f, "
+                        "\"eventsPerSecond\": %.1f, \"deliveriesPerSecond\": %.1f, \"enqueueNs\": %.1f,\n"
+                        "     \"latencyNs\": {\"mean\": %.1f, \"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"p999\": %.1f, \"max\": %.1f}}",
+                        (first)? "" : ",", mix->name, numProducers, numListeners, seconds, eventsPerSecond,
+                        deliveriesPerSecond, enqueueNs, latency.mean, latency.p50, latency.p90, latency.p99,
+                        latency.p999, latency.max);
+                first = false;
+
+                if (numProducers == maxProducers){
+                    break;
+                }
+            }
+        }
+    }
+    fprintf(output, "\n  ]\n}\n");
+    fclose(output);
+
+    /* Clean up */
+    free(run.latencies);
+    destroyEngine(engine);
+
+    return 0;
+}
+
+/* Mask mixes */
+static void setupMaskMixes(){
+    // every event is a key press, and every listener wants them (like a screen full of selection windows)
+    mixes[0].name = "keyboard";
+    mixes[0].eventTypes[0] = EVENT_KEYBOARD;
+    mixes[0].numEventTypes = 1;
+    mixes[0].listenerMasks[0] = EVENT_KEYBOARD;
+    mixes[0].numListenerMasks = 1;
+
+    // mostly timer events, like the main loop sends, with some key presses and game messages;
+    // listeners each want one or two of the types, so most events only reach some of them
+    mixes[1].name = "mixed";
+    mixes[1].eventTypes[0] = EVENT_TIMER;
+    mixes[1].eventTypes[1] = EVENT_TIMER;
+    mixes[1].eventTypes[2] = EVENT_KEYBOARD;
+    mixes[1].eventTypes[3] = EVENT_TIMER;
+    mixes[1].eventTypes[4] = EVENT_TIMER;
+    mixes[1].eventTypes[5] = EVENT_TIMER;
+    mixes[1].eventTypes[6] = EVENT_GAMEMSG;
+    mixes[1].eventTypes[7] = EVENT_TIMER;
+    mixes[1].numEventTypes = 8;
+    mixes[1].listenerMasks[0] = EVENT_KEYBOARD;
+    mixes[1].listenerMasks[1] = EVENT_GAMEMSG;
+    mixes[1].listenerMasks[2] = EVENT_KEYBOARD | EVENT_GAMEMSG;
+    mixes[1].listenerMasks[3] = EVENT_TIMER;
+    mixes[1].numListenerMasks = 4;
+
+    // the same events, but every listener wants all of them
+    mixes[2] = mixes[1];
+    mixes[2].name = "broadcast";
+    mixes[2].listenerMasks[0] = EVENT_KEYBOARD | EVENT_GAMEMSG | EVENT_TIMER;
+    mixes[2].numListenerMasks = 1;
+}
+
+/* Producers */
+static int producerThreadFunction(void* data){
+    Producer* producer = (Producer*)data;
+    MaskMix* mix = run.mix;
+    uint64_t interval = (producerRate > 0)? 1000000000 / producerRate : 0;
+    uint64_t enqueueTime = 0;
+
+    enterThreadBarrier(&run.startBarrier);
+    uint64_t startTime = getTimens();
+    for (int i = 0; i < producer->numEvents; i++){
+        /* Keep to the rate */
+        if (interval != 0){
+            uint64_t deadline = startTime + (interval * i);
+            uint64_t now = getTimens();
+            while (now < deadline){
+                if (deadline - now > 1000000){
+                    sleepms(1);
+                } else {
+                    yieldThread();
+                }
+                now = getTimens();
+            }
+        }
+
+        /* Send event */
+        // the memory is managed by the event thread once it's sent, same as in the game
+        BenchEvent* benchEvent = (BenchEvent*) malloc(sizeof(BenchEvent));
+        benchEvent->event.eventType.mask = mix->eventTypes[(producer->firstEvent + i) % mix->numEventTypes];
+        benchEvent->event.eventData = (void*)(uintptr_t)i;
+        benchEvent->event.timestamp = 0; // latency is measured here instead, in nanoseconds
+        benchEvent->event.next = NULL;
+
+        // the event can be dispatched and freed as soon as it's queued, so keep our own copy of the timestamp
+        uint64_t queuedTime = getTimens();
+        benchEvent->queuedTime = queuedTime;
+        engine->handleEvent(engine, &benchEvent->event);
+        enqueueTime += getTimens() - queuedTime;
+    }
+    producer->enqueueTime = enqueueTime;
+
+    return 0;
+}
+
+/* Dispatch */
+// Called on the event thread for every event
+static void benchPanelHandleEvent(Object* self, Event* event){
+    dispatchPanelEvent(self, event);
+    uint64_t now = getTimens();
+
+    run.latencies[run.dispatched++] = now - ((BenchEvent*)event)->queuedTime;
+    if (run.dispatched == run.totalEvents){
+        lockThreadLock(&run.lock);
+        run.endTime = now;
+        run.done = true;
+        sendConditionSignal(&run.finished);
+        unlockThreadLock(&run.lock);
+    }
+}
+
+static void benchListenerHandleEvent(Object* self, Event* event){
+    ((BenchListener*)self)->received++;
+}
+
+/* Results */
+static int compareLatencies(const void* a, const void* b){
+    uint64_t latencyA = *(const uint64_t*)a;
+    uint64_t latencyB = *(const uint64_t*)b;
+    return (latencyA > latencyB) - (latencyA < latencyB);
+}
+
+// Sorts latencies, and finds the mean, max, and nearest-rank percentiles
+static LatencySummary summarizeLatencies(uint64_t* latencies, int count){
+    LatencySummary summary;
+    qsort(latencies, count, sizeof(uint64_t), compareLatencies);
+
+    double total = 0;
+    for (int i = 0; i < count; i++){
+        total += latencies[i];
+    }
+    summary.mean = total / count;
+    summary.p50 = latencies[(int)ceil(0.50 * count) - 1];
+    summary.p90 = latencies[(int)ceil(0.90 * count) - 1];
+    summary.p99 = latencies[(int)ceil(0.99 * count) - 1];
+    summary.p999 = latencies[(int)ceil(0.999 * count) - 1];
+    summary.max = latencies[count - 1];
+    return summary;
+}
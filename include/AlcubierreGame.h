@@ -92,10 +92,15 @@ typedef struct AlcubierreGameState_s{
     Mission missions[9][3];
 
     /* Stats */
+    // widgets showing these are updated when their version changes (see markChanged())
     int shipHealth;
+    FieldVersion shipHealthVersion;
     int fleetStrength;
+    FieldVersion fleetStrengthVersion;
     int alienStrenth;
+    FieldVersion alienStrengthVersion;
     int credits;
+    FieldVersion creditsVersion;
 
 } AlcubierreGameState;
 extern AlcubierreGameState gameState;
@@ -28,22 +28,48 @@
 #include <panel.h>
 #include <events.h>
 #include <threads.h>
+#include <trace.h>
+#include <metrics.h>
 #include <stdint.h>
 
 /* Global variables */
 extern int MS_PER_FRAME; // determines framerate of engine
+extern int BUFFER_STRIDE; // number of cells in one row of the stdscr buffers (set by initializeEngine)
+extern int RENDER_THREADS; // number of threads used to rasterize each frame (1 = only the render thread, read when rendering starts)
+extern int OUTPUT_THREADS; // number of threads encoding each frame for the terminal (0 = print through curses, read when rendering starts)
+extern volatile int64_t bufferMemory; // bytes held by frame, panel, draw list, and output buffers (changed with atomicAdd64, see metrics.h)
+extern int nextColorPair; // next color pair getColorPair() will create (so nextColorPair - 1 are in use)
+
+/* Size of a cache line in bytes. Rows of the stdscr buffers are padded to a
+ * multiple of this, and the buffers themselves are aligned to it, so that every
+ * row starts on a fresh cache line.
+ */
+#define CACHE_LINE_SIZE 64
+
+// inputs that can be waiting to be shown on screen (see Engine.inputLatency)
+#define INPUT_QUEUE_SIZE 64
 
 /* Data Structures */
 struct Panel_s;
 
-/* Structure to hold characters and their attributes, ready to
- * print with curses
+/* Structure to hold characters and their attributes, packed into 4 bytes
+ * so that the buffers moved around every frame are as small as possible.
+ * glyph: index into the engine's glyph table (see getGlyph())
+ * style: packed color pair and attributes (see getCellStyle())
+ * Cells are only expanded back into a wchar_t and attr_t by the drawing
+ * thread, right before they are printed with curses.
  */
 typedef struct CursesChar_s{
-    attr_t attributes;
-    wchar_t character;
+    uint16_t glyph;
+    uint16_t style;
 } CursesChar;
 
+/* Glyph 0 is the NBSP (\u00A0) character, which is used as the transparent
+ * cell in every buffer. Glyphs 1-127 are always the ASCII character with
+ * the same value, so plain text doesn't need a table lookup.
+ */
+#define GLYPH_TRANSPARENT 0
+
 /* Object structure, holds all data common to 'objects'
  * for the engine. Objects are anything that is drawn
  * onto the screen, such as a panel or a game object.
@@ -107,6 +133,7 @@ typedef struct Panel_s{
     int width, height;
 
     /* Background buffer - rendered below any objects in this panel */
+    // row-major, width cells per row - char at (x, y) = backgroundBuffer + (width*y) + x
     CursesChar* backgroundBuffer;
 
     /* Event delegation */
@@ -127,6 +154,302 @@ typedef struct Panel_s{
     Object* childrenList;
 } Panel;
 
+/* Worker pools
+ * A group of threads which split up a job (a function called once for every index from
+ * 0 to numJobs-1) with the thread that started it. Indexes are claimed with atomic
+ * operations, so no locks are held while the job runs. A pool should only be used by
+ * the thread that created it.
+ */
+typedef void (*pfn_WorkerJob)(void* data, int index);
+
+typedef struct WorkerPool_s{
+    Thread_t* workers;
+    int numWorkers;
+    // releases the workers when a job is started
+    ThreadBarrier_t startBarrier;
+    // the current job
+    pfn_WorkerJob job;
+    void* jobData;
+    int numJobs;
+    // next index to be claimed, and the number of threads (including the one running the job)
+    // which have run out of indexes to claim
+    volatile int nextJob;
+    volatile int finishedWorkers;
+    // set before releasing the workers for the last time
+    bool exit;
+} WorkerPool;
+
+/* Starts a pool with numWorkers threads (which can be 0, in which case jobs just run on the calling thread)
+ */
+void createWorkerPool(WorkerPool* pool, int numWorkers);
+void destroyWorkerPool(WorkerPool* pool);
+
+/* Runs job(data, index) for every index from 0 to numJobs-1 on the pool's workers and the
+ * calling thread, and returns once they've all finished
+ */
+void runWorkerPool(WorkerPool* pool, pfn_WorkerJob job, void* data, int numJobs);
+
+/* Tiled rendering
+ * When RENDER_THREADS is more than 1, each frame is split into column bands (tiles)
+ * which are rasterized in parallel. Before a frame is rasterized the scene tree is
+ * compiled into a flat draw list (in z order), and every thread then draws the entries
+ * of that list which reach into its tile. writecharToBuffer() and drawBufferToBuffer()
+ * never write outside of the calling thread's tile, so any draw function using them
+ * is clipped automatically.
+ */
+typedef struct RenderTile_s{
+    // area of the frame this tile covers (relative to the top left of the viewport)
+    int x, y, width, height;
+} RenderTile;
+
+/* Area of an object's buffer that changed in an update (relative to the object)
+ * A width or height of 0 means nothing visible changed.
+ */
+typedef struct DirtyRect_s{
+    int x, y, width, height;
+} DirtyRect;
+
+typedef struct DrawListEntry_s{
+    // object to draw (or the panel whose background should be drawn)
+    Object* object;
+    // true if this entry only draws a panel's background buffer - its children get their own entries
+    bool panelBackground;
+    // position of the object in the frame, and the pointer into the render buffer at that position
+    int x, y;
+    CursesChar* buffer;
+} DrawListEntry;
+
+typedef struct DrawList_s{
+    DrawListEntry* entries;
+    int numEntries;
+    int maxEntries; // number of entries allocated
+} DrawList;
+
+/* Direct terminal output
+ * When OUTPUT_THREADS is 1 or more the drawing thread doesn't print frames through curses.
+ * Instead the viewport is split into bands of rows, and in parallel each band is diffed
+ * against what the terminal shows (finding runs of changed cells, so rows which haven't
+ * changed since they were last written, and the unchanged parts of rows that have, are
+ * skipped), and then its runs are encoded into its own buffer of escape sequences and text
+ * (SGR state is reset at the start of every band, so bands don't depend on each other).
+ * All bands are then written to the terminal with a single writev(). Curses is still used for input
+ * and the letterbox.
+ * (Only available on UNIX-like systems)
+ */
+// A run of cells in one row which changed since the row was last written
+typedef struct OutputRun_s{
+    int x, y, width;
+} OutputRun;
+
+typedef struct OutputBand_s{
+    // rows of the viewport in this band
+    int y, height;
+    // runs of changed cells found by the diff, which are then encoded
+    OutputRun* runs;
+    int numRuns;
+    int changedCells; // cells in the runs
+    // encoded output
+    char* bytes;
+    size_t length;
+    size_t capacity;
+    // copy of the rows last written to the terminal (width cells per row) - rows that haven't changed are skipped
+    // (points into the output's lastFrame)
+    CursesChar* lastRows;
+    bool redraw; // if true every row is written, even if it hasn't changed
+    bool redrawFirstRow; // if true the band's first row is written, even if it hasn't changed (the debug info line covers it)
+} OutputBand;
+
+/* Frame stages
+ * Every frame goes through these stages, and the time each one takes is measured (the wall
+ * clock time of the thread running it, in microseconds). Compose, rasterize, and swap wait
+ * run on the render thread, the rest on the drawing thread. Diff is only measured when frames
+ * are printed directly; when printing through curses, encode is copying the frame into curses
+ * and write is wrefresh() (where curses finds what changed and prints it).
+ */
+typedef enum FrameStage_e{
+    FRAME_STAGE_COMPOSE, // clearing the frame to the background, or flattening the scene into the draw list when tiled
+    FRAME_STAGE_RASTERIZE, // drawing every object into the frame (tiles are cleared as they're rasterized)
+    FRAME_STAGE_SWAP_WAIT, // waiting for the drawing thread to finish the last frame, so the buffers can be swapped
+    FRAME_STAGE_DIFF, // finding the cells that changed since the last frame was written
+    FRAME_STAGE_ENCODE, // encoding the changed cells into escape sequences
+    FRAME_STAGE_WRITE, // writing the frame to the terminal
+    FRAME_STAGE_COUNT
+} FrameStage;
+
+#define MAX_FRAME_INPUTS 16
+
+typedef struct FrameTimings_s{
+    int frameNumber; // see getFrameNumber()
+    uint32_t stageTime[FRAME_STAGE_COUNT];
+    int changedCells; // cells the diff found
+    size_t bytes; // bytes encoded
+    // timestamps of the input handled since the last frame started (see Event.timestamp) - this is the first
+    // frame that can show it, so once the frame has been presented those inputs have reached the screen
+    uint64_t inputTimes[MAX_FRAME_INPUTS];
+    int numInputs;
+} FrameTimings;
+
+/* Latency histograms
+ * Counts times (in microseconds) in buckets an eighth of a power of two wide, so a time is never more
+ * than 12.5% off from the bucket it's counted in, whether it's a few microseconds or a few seconds.
+ * Times under 8us get a bucket each, and times past the last bucket are counted in it.
+ */
+#define HISTOGRAM_BUCKETS 256
+
+typedef struct LatencyHistogram_s{
+    uint32_t counts[HISTOGRAM_BUCKETS];
+    uint32_t total;
+    uint64_t max;
+} LatencyHistogram;
+
+void clearLatencyHistogram(LatencyHistogram* histogram);
+void recordLatency(LatencyHistogram* histogram, uint64_t time);
+/* Takes back a time recorded earlier, for histograms over a rolling window
+ * (max isn't lowered - it stays the largest time ever recorded)
+ */
+void removeLatency(LatencyHistogram* histogram, uint64_t time);
+/* Returns the (upper end of the bucket holding the) nearest-rank percentile, percentile is from 0 to 1
+ * Returns 0 if nothing has been recorded
+ */
+uint64_t getLatencyPercentile(LatencyHistogram* histogram, double percentile);
+
+/* Frame stats
+ * Kept by the drawing thread from the timings of every frame it presents, over a window of the
+ * last FRAME_STATS_WINDOW frames - only the drawing thread touches them, so keeping them takes no
+ * locks. Shown over the game by the frame overlay (see setFrameOverlay()).
+ */
+#define FRAME_STATS_WINDOW 128
+
+typedef struct FrameStats_s{
+    /* The window (a ring, next is the oldest frame once it's full) */
+    uint32_t frameTimes[FRAME_STATS_WINDOW]; // time from presenting the frame before to presenting this one (us)
+    uint32_t stageTimes[FRAME_STATS_WINDOW][FRAME_STAGE_COUNT];
+    uint32_t bytes[FRAME_STATS_WINDOW];
+    int next, count;
+
+    /* Totals over the window */
+    LatencyHistogram frameTimeHistogram;
+    uint64_t stageTotals[FRAME_STAGE_COUNT];
+    uint64_t bytesTotal;
+
+    /* Since the engine started */
+    uint64_t lastPresentTime; // getTimeus(), 0 before the first frame
+    unsigned int framesPresented;
+    unsigned int droppedFrames; // frame deadlines (getFramePeriod() apart) that passed without a new frame
+} FrameStats;
+
+/* Draw profile
+ * While profiling draws (see startDrawProfile()) the render thread times every drawObject() call, and adds
+ * the time up for each object, and for each type of object (objects with the same draw function). Panels
+ * using the default draw function are flattened like they are for tiled rendering (see compileDrawList()),
+ * so a panel's own cost is drawing its background, and its children are timed on their own.
+ * Only used by the render thread.
+ */
+#define DRAW_PROFILE_OBJECTS 1024 // objects are only counted in their type past this many
+#define DRAW_PROFILE_TYPES 64
+
+typedef struct DrawCost_s{
+    const void* key; // the object, or for types its draw function (NULL if the slot is empty)
+    const void* type; // the object's draw function (kept, since the object may be gone by the time it's reported)
+    uint64_t time; // ns
+    unsigned int draws;
+    int x, y; // where the object was last drawn
+} DrawCost;
+
+typedef struct DrawProfile_s{
+    FILE* file; // snapshots, and the totals when the engine is destroyed
+    uint64_t budget; // frames that take longer than this to compose and rasterize are snapshotted (ns)
+
+    // time spent drawing each draw list entry this frame, with a row of maxEntries for each tile
+    uint64_t* entryTimes;
+    int maxEntries, numRows;
+
+    // totals (open addressed by key)
+    DrawCost objects[DRAW_PROFILE_OBJECTS];
+    DrawCost types[DRAW_PROFILE_TYPES];
+    uint64_t totalTime;
+    unsigned int frames, slowFrames, snapshots;
+    uint64_t lastSnapshot; // getTimems() when the last snapshot was written
+} DrawProfile;
+
+/* Part of a frame which scrolled up (see scrollFrameArea())
+ * lines is 0 if nothing scrolled, or -1 if different areas scrolled in the same frame
+ */
+typedef struct FrameScroll_s{
+    int x, y, width, height;
+    int lines;
+} FrameScroll;
+
+/* Animation timers
+ * The render thread samples the clock once at the start of every frame (see getFrameTimems())
+ * and then runs every timer which has expired, before the frame is rasterized. Pending timers
+ * are kept in a hierarchical timer wheel: TIMER_WHEEL_LEVELS wheels of TIMER_WHEEL_SLOTS slots,
+ * where a slot on level 0 is 1 ms and a slot on every level above covers a whole turn of the
+ * wheel below it. Timers are put on the lowest level that reaches their deadline and are moved
+ * down when the wheel below wraps around, so scheduling, cancelling, and running a timer
+ * don't depend on how many timers are pending.
+ */
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 4
+
+// Called from the render thread with the time of the frame it's running in. Timer functions
+// can't be called from a callback (the timer wheel is locked while it runs)
+// returns: the time to run the timer again at, or 0 if it's finished
+typedef uint64_t (*pfn_TimerCallback)(void* data, uint64_t frameTime);
+
+typedef struct Timer_s{
+    uint64_t deadline; // time (see getTimems()) the timer should run at
+    pfn_TimerCallback callback;
+    void* data;
+    bool scheduled;
+    // list of timers in the same slot
+    struct Timer_s* next;
+    struct Timer_s** previousNext; // the pointer pointing to this timer, so it can be removed without searching the slot
+} Timer;
+
+/* Render backends
+ * A backend is where the drawing thread sends finished frames. The terminal backend prints
+ * them (through curses, or directly when OUTPUT_THREADS is 1 or more), and the headless
+ * backend keeps them in memory, so the engine can run with no terminal at all (ex. for
+ * measuring render performance). Every function is passed the backend itself and the engine.
+ * initialize: called by initializeEngine() before the buffers are set up. Sets up curses
+ *  and the engine's stdscr, stdscrWidth/Height, and viewportX/Y.
+ *  returns: false if the engine can't run on this backend
+ * start: called by the drawing thread once rendering starts
+ * presentFrame: called by the drawing thread (with the draw lock held) for every frame
+ * stop: called by the drawing thread when it exits
+ * destroy: called by destroyEngine() after the threads have exited, frees the backend
+ */
+struct Engine_s;
+typedef struct RenderBackend_s{
+    bool (*initialize)(struct RenderBackend_s* self, struct Engine_s* engine);
+    void (*start)(struct RenderBackend_s* self, struct Engine_s* engine);
+    void (*presentFrame)(struct RenderBackend_s* self, struct Engine_s* engine);
+    void (*stop)(struct RenderBackend_s* self, struct Engine_s* engine);
+    void (*destroy)(struct RenderBackend_s* self, struct Engine_s* engine);
+
+    // milliseconds between frames on this backend, or -1 to follow MS_PER_FRAME (see getFramePeriod())
+    int msPerFrame;
+
+    // data kept by the backend
+    void* data;
+} RenderBackend;
+
+/* Field versions
+ * A counter kept next to some state that other threads show (ex. a game stat drawn by a
+ * widget), bumped with markChanged() every time the state changes, so readers can tell if
+ * it changed since they last looked without comparing the state itself.
+ */
+typedef volatile int FieldVersion;
+#define markChanged(version) atomicIncrement(version)
+
+/* Adds object (and if it's a panel, its children) to the end of list, in the order they
+ * would be drawn. buffer points to the object's position in the render buffer, which is
+ * at (x, y) in the frame. Objects which aren't shown are left out.
+ */
+void compileDrawList(Object* object, CursesChar* buffer, int x, int y, DrawList* list);
+
 // Structure to hold any and all data needed to run the engine
 typedef struct Engine_s{
     /* The WINDOW* refernce returned by initscr
@@ -135,6 +458,9 @@ typedef struct Engine_s{
      */
     WINDOW* stdscr;
 
+    /* Where finished frames are sent (see RenderBackend) */
+    RenderBackend* backend;
+
     /* The main window for the engine */
     Panel* mainPanel;
     // width and height of the main window
@@ -148,7 +474,11 @@ typedef struct Engine_s{
     Panel* activePanel;
 
     /* Buffer of ncurses characters to print to the screen */
-    // Array stored in column-major order - char at (x, y) = screenBuffer + (height*x) + y
+    // The buffers only cover the game's viewport (width x height - the area mainPanel covers), not the whole
+    // terminal. The viewport is printed at (viewportX, viewportY) on the terminal, and the letterbox around
+    // it is only painted when the engine starts or the terminal is resized.
+    // Array stored in row-major order - char at (x, y) = screenBuffer + (stdscrStride*y) + x
+    // Each row is padded out to stdscrStride cells so every row starts on a cache line
     // Two buffers allocated for double buffer rendering system
     CursesChar* stdscrBuffer1;
     CursesChar* stdscrBuffer2;
@@ -156,8 +486,12 @@ typedef struct Engine_s{
     CursesChar* backgroundBuffer;
     // size of the above buffers in bytes
     int stdscrBufferSize;
-    // width and height of the screen
+    // width and height of the terminal (as of the last time the letterbox was painted)
     int stdscrWidth, stdscrHeight;
+    // number of cells in each row of the buffers (width rounded up to a whole number of cache lines)
+    int stdscrStride;
+    // position of the viewport on the terminal (top left corner)
+    int viewportX, viewportY;
 
     /* Event handler */
     /* Called for every event at the start of the game loop
@@ -183,6 +517,10 @@ typedef struct Engine_s{
         // Should the event thread exit?
         bool exit;
         /* End of dataLock resources */
+
+        /* Metrics (see metrics.h) */
+        volatile int queueDepth; // events queued but not dispatched yet (only changed with dataLock held)
+        volatile int eventsDispatched[EVENT_METRIC_TYPES]; // by type (only changed by the event thread)
     } eventThreadData;
 
     /* The render thread runs continously at a framerate defined by
@@ -211,6 +549,7 @@ typedef struct Engine_s{
         float fps_calculated; // The current fps being rendered
         unsigned int framesRendered; // The total number of frames that have been rendered
         ThreadCondition_t engineRenderReady; // don't start the render/draw/time threads until this is signaled
+        bool renderReady; // set when engineRenderReady is signaled
         /* end of dataMutex resources */
 
         ThreadLock_t renderLock;
@@ -222,7 +561,64 @@ typedef struct Engine_s{
         /* resources accessed by drawing thread */
         CursesChar** drawingBuffer; // pointer to the CursesChar buffer to draw from
         /* end of renderMutex resources */
+
+        /* Tiled rendering (only used by the render thread and its tile workers) */
+        // the render thread starts RENDER_THREADS-1 workers, and rasterizes tiles itself as well
+        // frame assembly is lock-free: each tile is written straight into the render buffer by whichever thread claimed it
+        WorkerPool tileWorkers;
+        RenderTile* tiles;
+        int numTiles;
+        DrawList drawList; // rebuilt by the render thread every frame
+        float rasterMs_calculated; // average time spent rasterizing a frame, updated with fps_calculated
+
+        /* Direct output (only used by the drawing thread and its output workers) */
+        // the drawing thread starts OUTPUT_THREADS-1 workers, and encodes bands itself as well
+        WorkerPool outputWorkers;
+        OutputBand* outputBands;
+        int numOutputBands; // 0 if printing through curses
+        CursesChar* lastFrame; // what the terminal shows, shared by the bands
+        bool scrollRegions; // can the terminal scroll some of its rows (DECSTBM)?
+        bool scrollMargins; // and only some of the columns in those rows (DECSLRM)?
+
+        /* Scroll hints (see scrollFrameArea()) */
+        FrameScroll renderScroll; // for the frame being rendered (render lock)
+        FrameScroll drawingScroll; // for the frame being drawn (draw lock)
+
+        /* Stage timings (see FrameTimings) */
+        FrameTimings renderTimings; // for the frame being rendered (render lock)
+        FrameTimings drawingTimings; // for the frame being drawn (draw lock) - complete once it's been presented
+
+        /* Frame stats (only used by the drawing thread) */
+        FrameStats frameStats;
+        volatile int showOverlay; // draw the frame overlay? (set from any thread, see setFrameOverlay())
+
+        /* Draw profile (see startDrawProfile()) */
+        DrawProfile* drawProfile; // NULL unless profiling draws
+
+        /* Metrics (see metrics.h) */
+        // copies of the frame stats counters, published by the drawing thread so they can be read without locks
+        volatile int framesEmitted; // frames presented by the backend
+        volatile int framesDropped; // see FrameStats.droppedFrames
+        // bytes of frames written to the terminal by the engine (only counted when printing directly, since curses
+        // doesn't say how much it writes)
+        volatile int64_t ttyBytes;
     } renderThreadData;
+
+    /* Input latency (see Event.timestamp) */
+    /* The event thread passes the timestamp of every stamped event it has handled to the render thread
+     * through handledInputs (one producer and one consumer, so no locks). The render thread gives them to
+     * the next frame it starts, and once that frame has been presented the drawing thread records how long
+     * each input took to reach the screen.
+     */
+    struct InputLatency_s{
+        uint64_t handledInputs[INPUT_QUEUE_SIZE];
+        volatile int handledHead; // next slot the event thread writes
+        volatile int handledTail; // next slot the render thread reads
+        volatile int dropped; // inputs that didn't fit in handledInputs or their frame (event and render thread)
+        /* Drawing thread resources */
+        LatencyHistogram histogram;
+        uint64_t lastLatency;
+    } inputLatency;
 } Engine;
 
 // Structure to hold data for game objects
@@ -249,6 +645,58 @@ typedef struct GameObject_s{
 Engine* initializeEngine(int width, int height);
 void destroyEngine(Engine* engine);
 
+/* Same as above, but sends frames to the given backend instead of the terminal.
+ * The engine owns the backend, and destroys it in destroyEngine().
+ */
+Engine* initializeEngineWithBackend(int width, int height, RenderBackend* backend);
+
+/* Creates a backend which prints frames to the terminal (the default backend)
+ */
+RenderBackend* createTerminalBackend();
+
+/* Creates a backend which renders into memory at the engine's size, with no terminal.
+ * Curses is pointed at /dev/null (as an xterm-256color terminal, so colors are the same on
+ * every machine).
+ * msPerFrame: milliseconds between frames (0 draws frames as fast as they can be rendered, -1 follows MS_PER_FRAME)
+ * If OUTPUT_THREADS is 1 or more frames are still encoded as they would be for a terminal,
+ * and the bytes are counted but not written.
+ * framePath: if not NULL, every frame is written to this file as text (after a line with its
+ *  number and checksum)
+ * checksumPath: if not NULL, the number and checksum of every frame are written to this file
+ * A summary (frames, fps, bytes encoded) is printed to stdout when the backend is destroyed.
+ */
+RenderBackend* createHeadlessBackend(const char* framePath, const char* checksumPath, int msPerFrame);
+
+/* Milliseconds between frames for the engine (its backend's frame period, or MS_PER_FRAME)
+ */
+int getFramePeriod(struct Engine_s* engine);
+
+/* Hashes the characters and styles of an area of a stdscr buffer (FNV-1a), so frames can
+ * be compared between runs. Glyph numbers aren't hashed, since they depend on the order
+ * characters were first drawn in.
+ */
+uint64_t checksumBuffer(CursesChar* buffer, int width, int height);
+
+/* Shows or hides the frame overlay, which is drawn into every frame (at the top left, under the
+ * debug info) with the frame stats: stage times, frame time percentiles and histogram, dropped
+ * frames, and bytes per frame. Can be called from any thread.
+ */
+void setFrameOverlay(Engine* engine, bool show);
+void toggleFrameOverlay(Engine* engine);
+
+/* Starts timing every object's draw (see DrawProfile). Whenever a frame takes longer than budgetms to
+ * compose and rasterize, a snapshot of the scene tree is written to path, with what every node cost to
+ * draw that frame (at most one snapshot a second). The total cost of each object type and the most
+ * expensive objects are written when the engine is destroyed. Must be called before rendering starts.
+ * Returns false if path can't be opened.
+ */
+bool startDrawProfile(Engine* engine, const char* path, int budgetms);
+
+/* Names the type of object drawn by the given draw function, for draw profiles
+ * (ex. setDrawFunctionName(XPSpriteDraw, "XPSprite") when creating a sprite)
+ */
+void setDrawFunctionName(void (*drawObject)(Object* self, CursesChar* buffer), const char* name);
+
 /* Creates and returns a panel, with the given width and height
  * and position relative to stdscr. The ncurses subwin and derwin
  * class of functions are not well implemented, according to
@@ -279,7 +727,7 @@ void getAbsolutePosition(Object* parent, int relX, int relY, int* absX, int* abs
  * NOTE: because of the way the stdscr buffers are layed out this function can
  * take a pointer to any part of the buffer, and it will use x and y as offsets from
  * that location, in other words x and y need not be absolute, only relative to the
- * pointer passed here.
+ * pointer passed here. Rows are BUFFER_STRIDE cells apart.
  */
 void writewcharToBuffer(CursesChar* buffer, int x, int y, attr_t attr, wchar_t wch);
 
@@ -290,29 +738,160 @@ void writecharToBuffer(CursesChar* buffer, int x, int y, CursesChar* ch);
 /* printf style formatting to print text to a buffer
  * NOTE: this function only accepts normal width (1 byte) characters
  * NOTE: unlike above functions, this function can be used with any buffer,
- *  not just buffers that are COLS wide and LINES tall. length is the width
- *  each line should be (doesn't need to be the width of the buffer), 
- *  and height is the height of the buffer (does need to be the actual height
+ *  not just the stdscr buffers. width is the width each line should be
+ *  (doesn't need to be the width of the buffer), and stride is the number
+ *  of cells in one row of the buffer (does need to be the actual row length
  *  for proper formatting)
- * NOTE: height is used for calculating offsets into buffer, and so should be 
- *  the height buffer was allocated at. maxHeight limits how much this function
+ * NOTE: stride is used for calculating offsets into buffer, and so should be 
+ *  the width buffer was allocated at. maxHeight limits how much this function
  *  will print, and is the number of lines it will print
  * returns: lines written
  */
-int bufferPrintf(CursesChar* buffer, int width, int height, int maxHeight, int x, int y, unsigned int attr, const char* format, ...);
+/* NOTE: the string is formatted into a buffer kept by the calling thread, which is
+ *  only reallocated when a longer string than before is printed
+ */
+int bufferPrintf(CursesChar* buffer, int width, int stride, int maxHeight, int x, int y, unsigned int attr, const char* format, ...);
+
+/* Same as bufferPrintf(), but prints str as is (no formatting)
+ */
+int bufferPutString(CursesChar* buffer, int width, int stride, int maxHeight, int x, int y, unsigned int attr, const char* str);
+
+/* Fills a width x height area at (x, y) of a buffer with stride cells per row (see
+ * bufferPrintf()) with the given character
+ */
+void bufferFill(CursesChar* buffer, int stride, int x, int y, int width, int height, attr_t attr, wchar_t wch);
+
+/* Copies a width x height row-major buffer into the given buffer (which is laid out
+ * like the stdscr buffers, see writecharToBuffer), skipping transparent cells.
+ * This is what most objects use to draw their pre-rendered buffer in drawObject()
+ */
+void drawBufferToBuffer(CursesChar* buffer, CursesChar* source, int width, int height);
+
+/* Clips a width x height area of a stdscr buffer (with its top left at buffer) to the
+ * calling thread's render tile (see RenderTile). The visible part of the area, relative
+ * to buffer, is returned through startX/startY (inclusive) and endX/endY (exclusive).
+ * Draw functions that write to the buffer themselves should only write inside this area.
+ * returns: false if none of the area is inside the tile
+ */
+bool clipToRenderTile(CursesChar* buffer, int width, int height, int* startX, int* startY, int* endX, int* endY);
+
+/* Tells the output that a width x height area of the frame being rendered (with its top
+ * left at x, y in the frame) shows what was lines rows further down in the last frame
+ * (ex. text scrolling up). If the terminal can scroll that part of the screen it's
+ * scrolled there instead of being printed again (curses finds scrolled rows by itself).
+ * This is only a hint: any cell that doesn't match after scrolling is still printed.
+ * Call with the render lock held (or from the render thread, ex. in a timer)
+ */
+void scrollFrameArea(Engine* engine, int x, int y, int width, int height, int lines);
+
+/* Borders
+ * Box borders are drawn from templates, which hold the pre-built rows of a border of
+ * one style and width: the top and bottom edges, and the cell on each side of every
+ * row in between. Templates are built the first time a style and width are asked
+ * for and shared by everything with the same border after that (they're never freed).
+ * Drawing a border only writes the edges, so the inside can be kept in a separate
+ * buffer and updated without touching the border.
+ */
+typedef enum BorderStyle_e{
+    BORDER_SINGLE, // ┌─┐
+    BORDER_DOUBLE, // ╔═╗
+    BORDER_STYLE_COUNT
+} BorderStyle;
+
+typedef struct BorderTemplate_s{
+    BorderStyle style;
+    int width;
+    CursesChar* top; // width cells, including the corners
+    CursesChar* bottom;
+    CursesChar left, right;
+    struct BorderTemplate_s* next; // next template of the same style in the cache
+} BorderTemplate;
+
+/* Gets the template for a border of the given style and width (at least 2)
+ */
+const BorderTemplate* getBorderTemplate(BorderStyle style, int width);
+
+/* Draws a border height rows tall into a row-major buffer with stride cells per row
+ * (see bufferPrintf()), with its top left at (x, y)
+ */
+void bufferDrawBorder(CursesChar* buffer, int stride, int x, int y, const BorderTemplate* border, int height);
+
+/* Draws a border height rows tall into a stdscr buffer, with its top left at buffer
+ * (like drawBufferToBuffer())
+ */
+void drawBorderToBuffer(CursesChar* buffer, const BorderTemplate* border, int height);
+
+/* Allocates/frees a buffer aligned to CACHE_LINE_SIZE
+ */
+void* allocateAlignedBuffer(size_t size);
+void freeAlignedBuffer(void* buffer);
 
 /* Returns a timestamp in milliseconds, from an undefined
  * starting time. (Monotonic clock)
  */
 uint64_t getTimems();
 
+/* Same as getTimems(), but in microseconds (for timing things that take less than a millisecond)
+ */
+uint64_t getTimeus();
+
+/* Same as getTimems(), but in nanoseconds (for timing things that take less than a microsecond)
+ */
+uint64_t getTimens();
+
+/* Returns the timestamp (see getTimems()) the frame currently being rendered was
+ * started at. Draw functions should use this instead of getTimems() so that every
+ * tile of a frame sees the same time.
+ */
+uint64_t getFrameTimems();
+
+/* Counts the frames the render thread has started, for draw functions that need to
+ * know if they were drawn in the last frame
+ */
+int getFrameNumber();
+
 /* Sleeps for a given number of milliseconds
  */
 void sleepms(int msec);
 
+/* Schedules a timer (see Timer) to run callback(data, frameTime) on the first frame at or after
+ * deadline, or cancels it. A timer which is already scheduled is moved to the new deadline.
+ */
+void scheduleTimer(Timer* timer, uint64_t deadline, pfn_TimerCallback callback, void* data);
+void cancelTimer(Timer* timer);
+
+/* Same as sleepms(), but on the engine's frame clock - wakes up on the first frame at least
+ * msec milliseconds from now, so game delays line up with the frames they show up in
+ */
+void waitms(int msec);
+
 /* Get colors and color pairs
  */
 int getBestColor(int r, int g, int b, Engine* engine);
 int getColorPair(int fg, int bg, Engine* engine);
 
+/* Forgets every color and color pair made by the functions above, so the next calls start
+ * from the terminal's standard colors again (what's already on screen keeps the old colors
+ * until it's redrawn). Used by benchmarks to measure a cold palette.
+ */
+void resetColors(Engine* engine);
+
+/* Sets up the glyph and style tables below, called by initializeEngine()
+ */
+void initializeCellTables();
+
+/* Glyph table - maps the 16 bit glyph stored in a CursesChar to a wide character
+ * getGlyph: returns the glyph for a character, adding it to the table if needed
+ * getGlyphCharacter: returns the character a glyph stands for
+ */
+uint16_t getGlyph(wchar_t wch);
+wchar_t getGlyphCharacter(uint16_t glyph);
+
+/* Cell styles - a curses color pair (low 8 bits) and attribute flags (high 8 bits)
+ * getCellStyle: packs curses attributes (ex. COLOR_PAIR(n) | A_BOLD) into a style
+ * getCellAttributes: unpacks a style back into curses attributes
+ */
+uint16_t getCellStyle(attr_t attr);
+attr_t getCellAttributes(uint16_t style);
+
 #endif //__ENGINE_H_
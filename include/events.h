@@ -9,6 +9,8 @@
 #ifndef __EVENTS_H__
 #define __EVENTS_H__
 
+#include <stdint.h>
+
 /* Event Structure */
 /* NOTE: this structure should always be allocated on the heap with malloc,
  * since it will be shared between threads and the memory may be read and
@@ -17,6 +19,7 @@
  * Two fields:
  *      eventType - 4 bytes - describes the type of event
  *      eventData - void pointer - points to data for event
+ *      timestamp - 8 bytes - when the input behind the event was read
  * eventType:
  *      union allows the data to be interpreted as a:
  *      (1) unsigned 32 bit integer (mask for binary operations)
@@ -36,6 +39,11 @@
  *      event. This should never be the only reference to a pointer
  *      returned by malloc, since no effort is made to free this
  *      memory when freeing the memory for an event
+ * timestamp:
+ *      for events caused by input (key presses), the time the input was
+ *      read (getTimeus()), otherwise 0. Once a stamped event has been
+ *      handled, the engine follows it to the first frame that can show
+ *      its effects, and records how long it took to reach the screen.
  */
 typedef union EventTypeMask_u{
     unsigned int mask;
@@ -50,6 +58,7 @@ typedef union EventTypeMask_u{
 typedef struct Event_s{
     EventTypeMask eventType;
     void* eventData;
+    uint64_t timestamp;
     struct Event_s* next; // Used to make a linked list event queue
 } Event;
 
@@ -12,6 +12,7 @@
 #include <AlcubierreGame.h>
 #include <objects/sprites.h>
 #include <objects/Room.h>
+#include <objects/ui.h>
 
 typedef struct BaseMissionScreenState_s{
     // background
@@ -31,6 +32,7 @@ typedef struct BaseMissionScreenState_s{
         MODE_TARGET_ENEMY,
         MODE_TARGET_ASSIST,
     } mode;
+    FieldVersion modeVersion;
 
     // Ship
     GameObject* shipObject;
@@ -85,6 +87,12 @@ typedef struct BaseMissionScreenState_s{
     int playerLaserX, playerLaserY;
     int playerMissileX, playerMissileY;
     int enemyLaserX, enemyLaserY;
+    // cells drawn for the bolts/missiles (colors are looked up once, when the screen is built)
+    CursesChar playerLaserChar, playerMissileChar, enemyLaserChar;
+
+    // widgets updated from the game state (see bindWidget())
+    BindingList bindings;
+    attr_t fullChargeAttr; // engine charge bar attributes once the engines can jump
 } BaseMissionScreenState;
 extern BaseMissionScreenState baseMissionScreenState;
 extern ThreadLock_t baseMissionScreenStateLock;
@@ -10,6 +10,7 @@
 
 #include <AlcubierreGame.h>
 #include <objects/sprites.h>
+#include <objects/ui.h>
 
 typedef struct OverviewScreenState_s{
     Panel* missionSelectionPanel;
@@ -23,11 +24,13 @@ typedef struct OverviewScreenState_s{
     GameObject* endText;
 
     GameObject* locationMarkers[9];
+    // true for markers that are animated (AXP) sprites, so they're destroyed with the right function
+    bool locationMarkerAnimated[9];
     // true for any locations that need to be updated when updateOverviewScreen is called
     bool locationStatusChanged[9];
     int locationMarkerStartX;
     XPFile* locationUnknownTexture;
-    XPFile* locationCurrentFrames[2];
+    AXPSpriteTextureData* locationCurrentTexture; // shared by every current location marker
     XPFile* locationCompletedTexture;
     XPFile* locationSkippedTexture;
 
@@ -36,6 +39,8 @@ typedef struct OverviewScreenState_s{
     GameObject* fleetStrengthProgressBar;
     GameObject* alienStrengthProgressBar;
     GameObject* creditsTextBox;
+    // keeps the status bar in sync with gameState
+    BindingList bindings;
 } OverviewScreenState;
 extern OverviewScreenState overviewScreenState;
 extern ThreadLock_t overviewScreenStateLock;
@@ -0,0 +1,43 @@
+/*
+ * Created by Sean Bowers
+ * CS 2060 section 3, Spring 2018
+ * University of Colorado at Colorado Springs
+ *
+ * Licensed under the MIT License (see LICENSE.txt)
+ */
+/* Metrics server
+ * Serves the engine's counters and gauges as text over a Unix domain socket, so a local agent can
+ * scrape them (ex. socat - UNIX-CONNECT:/tmp/alcubierre.sock). Every connection gets one snapshot in
+ * the Prometheus text format, and is then closed.
+ *
+ * The counters live in the engine (see the metrics sections of eventThreadData and renderThreadData).
+ * Each one is only changed by one thread, or while a lock that's already held for something else is
+ * held, so keeping them up to date doesn't add any locks. The server reads them with atomic loads.
+ * (Only available on UNIX-like systems)
+ */
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include <stdbool.h>
+
+struct Engine_s;
+
+/* Events dispatched are counted by type (see eventThreadData.eventsDispatched) */
+typedef enum EventMetricType_e{
+    EVENT_METRIC_KEYBOARD,
+    EVENT_METRIC_GAMEMSG,
+    EVENT_METRIC_TIMER,
+    EVENT_METRIC_OTHER,
+    EVENT_METRIC_TYPES
+} EventMetricType;
+
+/* Starts serving the engine's metrics on a socket at path (a stale socket already at path is replaced).
+ * Returns false if the socket couldn't be created.
+ */
+bool startMetricsServer(struct Engine_s* engine, const char* path);
+
+/* Stops the server and removes its socket. Must be called before the engine is destroyed.
+ */
+void stopMetricsServer();
+
+#endif //__METRICS_H__
@@ -24,6 +24,7 @@ typedef struct EnemyBaseData_s{
 
     /* Game data */
     float weaponsCharge;
+    FieldVersion weaponsChargeVersion;
 } EnemyBaseData;
 
 GameObject* createEnemyBase(int x, int y, int z, Engine* engine);
@@ -31,10 +31,13 @@ typedef struct ShipData_s{
     int shieldPower;
     int weaponsPower;
     int pilotPower;
+    FieldVersion powerVersion; // any of the power fields above
 
     float engineCharge;
+    FieldVersion engineChargeVersion;
     float weapons1Charge;
     float weapons2Charge;
+    FieldVersion weaponsChargeVersion; // either weapon's charge
 } ShipData;
 
 GameObject* createPlayerShip(int x, int y, int z, Engine* engine);
@@ -35,17 +35,60 @@ void destroyXPSprite(GameObject* sprite);
 
 /* AXP Sprite - animated sprite */
 
+/* Frames are stored as keyframes (a full width*height buffer) or as a list of the cells
+ * that change from the last keyframe. A frame is only stored as changes if that takes
+ * less than half the memory of a keyframe, and no cell changes between transparent and
+ * opaque (so the keyframe can always be drawn under it).
+ */
+typedef struct AXPSpriteCellChange_s{
+    uint32_t index; // (width*y) + x
+    CursesChar cell;
+} AXPSpriteCellChange;
+
+typedef struct AXPSpriteFrame_s{
+    bool isKeyframe; // if true this frame owns cells and opaqueRows
+    // cells of the keyframe this frame is drawn on top of (its own cells if it's a keyframe)
+    CursesChar* cells;
+    // for each row of cells, true if it doesn't have any transparent cells (so it can be copied all at once)
+    bool* opaqueRows;
+    // cells that are different from the keyframe
+    AXPSpriteCellChange* changes;
+    int numChanges;
+} AXPSpriteFrame;
+
+/* Textures are immutable once created, and shared (refcounted) between every sprite made from
+ * them, so creating a sprite from an existing texture doesn't copy or rasterize anything.
+ */
 typedef struct AXPSpriteTextureData_s{
     int width, height;
-    CursesChar** frames; // array of buffers for each frame
+    int numFrames;
+    AXPSpriteFrame* frames; // array of frames
+    volatile int refCount; // number of sprites (and other owners) using this texture
 } AXPSpriteTextureData;
 
+/* Sprites are advanced by an engine timer (see Timer) instead of when they're drawn. A sprite
+ * that wasn't drawn in the last frame (hidden or off screen) stops its timer until it's drawn
+ * again, and then catches up to the frame it should be on.
+ */
 typedef struct AXPSpriteData_s{
-    XPFile** textures; // Original texture files
-    AXPSpriteTextureData* textureData; // Data optimized for rendering
-    int msPerFrame, currentFrame, lastFrameTime, numFrames; // fps this animation runs at
+    AXPSpriteTextureData* textureData; // Shared data optimized for rendering
+    /* Playback state (owned by this sprite) */
+    int currentFrame; // frame being shown
+    uint64_t lastFrameTime; // time (ms) currentFrame started being shown
+    int msPerFrame, numFrames; // fps this animation runs at, and the number of frames to loop through
+    Timer timer; // advances currentFrame
+    volatile int lastDrawnFrame; // last frame number (see getFrameNumber()) the sprite was drawn in
+    volatile int stopped; // 1 if the timer isn't scheduled because the sprite isn't being drawn
 } AXPSpriteData;
 
+// Rasterizes the frames into a new texture, owned by the caller (refCount = 1)
+AXPSpriteTextureData* createAXPSpriteTexture(XPFile** textures, int numFrames, Engine* engine);
+// Drops a reference to the texture, freeing it when nothing uses it anymore
+void releaseAXPSpriteTexture(AXPSpriteTextureData* texture);
+
+// Creates a sprite that shares the given texture
+GameObject* createAXPSpriteFromTexture(AXPSpriteTextureData* texture, int msPerFrame, int xpos, int ypos, int zorder);
+// Creates a sprite with its own texture (same as createAXPSpriteTexture() followed by createAXPSpriteFromTexture())
 GameObject* createAXPSprite(XPFile** textures, int numFrames, int msPerFrame, int xpos, int ypos, int zorder, Engine* engine);
 void destroyAXPSprite(GameObject* sprite);
 
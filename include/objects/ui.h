@@ -27,46 +27,126 @@
 typedef void(*pfn_SelectionCallback)(int index);
 
 typedef struct SelectionWindowData_s{
+    // holds the options (without the border), bufferWidth x bufferHeight
     CursesChar* buffer;
+    int bufferWidth, bufferHeight;
     char** list;
     char* keys; // array of chars - not string
     pfn_SelectionCallback* callbacks;
     pfn_SelectionCallback selectionChangedCallback;
-    int width, height;
+    int width, height; // size of the whole window, including the border
     int numOptions;
     bool bordered;
+    const BorderTemplate* border; // drawn around the buffer, NULL if not bordered
     bool arrowSelection;
     int currentSelection; // only used with arrowSelection
+    /* Scrolling */
+    // only visibleRows options are drawn to the buffer, starting at firstVisible
+    int visibleRows;
+    int firstVisible;
+    /* Hotkeys */
+    // index of the option selected by each key, or -1 if the key isn't used
+    int hotkeys[256];
 } SelectionWindowData;
 
 // Bordered: should we draw a border around the options (also makes the panel opaque in blank spaces)
 // arrowSelection: should we allow the arrow keys to select options (change highlighting), and call callback when enter is pressed
+// keys: the hotkey for each option - if more than one option has the same key, only the first one's callback is called (a later option's duplicate key is ignored)
 GameObject* createSelectionWindow(char** list, char* keys, bool bordered, bool arrowSelection, pfn_SelectionCallback* callbacks, pfn_SelectionCallback selectionChangedCallback, bool registerForEvents, int numOptions, int minWidth, int xpos, int ypos, int z, Engine* engine);
+// Same as createSelectionWindow, but only visibleRows options are shown at a time, and the window scrolls to keep the selection visible
+GameObject* createScrollingSelectionWindow(char** list, char* keys, bool bordered, bool arrowSelection, pfn_SelectionCallback* callbacks, pfn_SelectionCallback selectionChangedCallback, bool registerForEvents, int numOptions, int visibleRows, int minWidth, int xpos, int ypos, int z, Engine* engine);
 void destroySelectionWindow(GameObject* selectionWindow);
 
 // call if updating any data from the outside
 void drawSelectionWindowBuffer(GameObject* selectionWindow);
 
+// moves the selection (scrolling if needed), only redraws the rows that changed
+// does not call the selection changed callback
+void setSelectionWindowSelection(GameObject* selectionWindow, int selection);
+
 
 
 /* Text box */
 /* A simple gameObject which renders text to the screen. Can optionally have a border
  */
 
+// where one line of the text is printed in the text box
+typedef struct TextBoxLine_s{
+    int start, length; // characters of text on this line
+} TextBoxLine;
+
+// Splits text into lines of at most width characters, the same way bufferPrintf() wraps it
+// lines can be NULL to only count the lines, otherwise maxLines lines are filled in (unused lines are empty)
+// returns: the number of lines with text on them (at most maxLines)
+int layoutText(const char* text, int width, TextBoxLine* lines, int maxLines);
+
 typedef struct TextBoxData_s{
     char* text;
+    int textCapacity; // bytes allocated for text
     attr_t attributes;
+    int width, height; // size of the whole text box, including the border
+    bool bordered;
+    const BorderTemplate* border; // drawn around the buffer, NULL if not bordered
+    // holds the inside of the text box (without the border), textWidth x textHeight
     CursesChar* buffer;
-    int bufferWidth, bufferHeight;
     int textWidth, textHeight;
-    bool bordered;
+    /* Layout of the text currently in the buffer */
+    // updates only redraw the rows where the layout or text changed
+    bool center;
+    int textX; // column the lines start at
+    TextBoxLine* lines; // textHeight lines
+    TextBoxLine* newLines; // space to lay out new text in, swapped with lines after an update
 } TextBoxData;
 
 GameObject* createTextBox(const char* text, attr_t attributes, bool bordered, int width, int height, int x, int y, int z, Engine* engine);
 void destroyTextBox(GameObject* textBox);
 
 // changes the text in the text box
-void updateTextBox(GameObject* textBox, const char* newText, attr_t attributes, bool center);
+// returns: the rows that changed (nothing if the text, attributes, and centering are the same)
+DirtyRect updateTextBox(GameObject* textBox, const char* newText, attr_t attributes, bool center);
+
+
+
+/* Text crawl */
+/* Text which crawls up from the bottom of a box, one line at a time. The text is laid
+ * out once when the crawl is created. Each step moves the rows already on screen up by
+ * one (the buffer is a ring of rows, so nothing is copied) and draws the next line of
+ * text at the bottom, or a blank line once the text runs out. The output is told that
+ * the rows scrolled (see scrollFrameArea()), so it doesn't have to print them again.
+ */
+typedef struct TextCrawlData_s{
+    Engine* engine;
+    char* text;
+    TextBoxLine* lines;
+    int numLines;
+    uint16_t style;
+    // ring of height rows, width cells each
+    CursesChar* buffer;
+    int width, height;
+    int topRow; // row of the buffer shown at the top of the crawl
+    int step; // number of lines that have crawled in
+} TextCrawlData;
+
+GameObject* createTextCrawl(const char* text, attr_t attributes, int width, int height, int x, int y, int z, Engine* engine);
+void destroyTextCrawl(GameObject* textCrawl);
+
+// moves the crawl up a line - call with the render lock held
+// returns: true if the new line has text on it, false once the text has run out
+bool advanceTextCrawl(GameObject* textCrawl);
+
+
+
+/* Frame */
+/* Just a border (see getBorderTemplate()), for framing a panel or other objects
+ * that don't draw their own
+ */
+typedef struct FrameData_s{
+    const BorderTemplate* border;
+    int width, height;
+} FrameData;
+
+GameObject* createFrame(BorderStyle style, int width, int height, int x, int y, int z);
+void destroyFrame(GameObject* frame);
 
 
 
@@ -77,12 +157,59 @@ typedef struct ProgressBarData_s{
     float percentage;
     CursesChar* buffer;
     int bufferWidth, bufferHeight;
+    // position and width of the bar (inside the brackets)
+    int barX, barWidth;
+    // what's currently in the buffer, so updates only need to redraw what changed
+    int filledWidth; // number of filled (#) cells (-1 if the bar hasn't been drawn yet)
+    attr_t attributes;
 } ProgressBarData;
 
 GameObject* createProgressBar(const char* label, float percentage, attr_t attributes, int width, int x, int y, int z, Engine* engine);
 void destroyProgressBar(GameObject* progressBar);
 
 // updates the percentage for the progress bar
-void updateProgressBar(GameObject* progressBar, float newPercentage, attr_t attributes);
+// returns: the cells that changed (nothing if the percentage rounds to the same number of filled cells)
+DirtyRect updateProgressBar(GameObject* progressBar, float newPercentage, attr_t attributes);
+
+
+
+/* Widget bindings */
+/* A binding connects an update function, which updates some widgets from the game state,
+ * to the FieldVersions of the state it reads. Once a binding list is started it's checked
+ * at the start of every frame (on the render thread, before the frame is drawn) and only
+ * the update functions with a source that changed since they last ran are called. Update
+ * functions can't use timer functions (see pfn_TimerCallback).
+ */
+#define MAX_BINDING_SOURCES 4
+
+typedef void (*pfn_BindingUpdate)(void* data);
+
+typedef struct WidgetBinding_s{
+    pfn_BindingUpdate update;
+    void* data;
+    FieldVersion* sources[MAX_BINDING_SOURCES];
+    int seenVersions[MAX_BINDING_SOURCES]; // version of each source when update last ran
+    int numSources;
+    struct WidgetBinding_s* next;
+} WidgetBinding;
+
+typedef struct BindingList_s{
+    WidgetBinding* bindings;
+    Timer timer;
+} BindingList;
+
+void createBindingList(BindingList* list);
+void destroyBindingList(BindingList* list);
+
+// binds update(data) to numSources FieldVersion pointers - update is called on the first frame after the list is started,
+// and then whenever any of the sources change
+void bindWidget(BindingList* list, pfn_BindingUpdate update, void* data, int numSources, ...);
+
+// starts checking the list every frame, nothing should be bound to the list after this
+void startBindingList(BindingList* list);
+
+// calls the update functions of bindings whose sources changed
+// returns: the number of update functions called
+int updateBindings(BindingList* list);
 
 #endif //__UI_H_
@@ -13,6 +13,7 @@
 
 #ifdef __UNIX__
 #include <pthread.h>
+#include <sched.h>
 
 // macOS does not implement pthread barriers correctly, so this is a re-implementation using other pthread features
 // code from http://blog.albertarmea.com/post/47089939939/using-pthreadbarrier-on-mac-os-x
@@ -121,9 +122,24 @@ typedef SYNCHRONIZATION_BARRIER ThreadBarrier_t;
  * broadcastConditionSignal(ThreadCondition_t* condition) // wakes all threads waiting on signal
  * 
  * enterThreadBarrier(ThreadBarrier_t* barrier)
+ * destroyBarrier(ThreadBarrier_t* barrier) // no threads can be waiting at the barrier
  * 
  * exitThread(int returnCode)
  * joinThread(Thread_t* handle)
+ * yieldThread() // give up the rest of this thread's time slice
+ *
+ * Atomic operations on an int shared between threads (no locks needed)
+ * atomicIncrement(volatile int* value) // returns the new value
+ * atomicDecrement(volatile int* value) // returns the new value
+ * atomicLoad(volatile int* value)
+ * atomicStore(volatile int* value, int newValue)
+ * atomicExchange(volatile int* value, int newValue) // returns the old value
+ *
+ * And on a 64 bit int (for counters that could pass 2^31)
+ * atomicAdd64(volatile int64_t* value, int64_t amount) // returns the new value
+ * atomicLoad64(volatile int64_t* value)
+ *
+ * THREAD_LOCAL - storage class for variables with one copy per thread
  */
 
 #ifdef __UNIX__
@@ -160,6 +176,9 @@ typedef SYNCHRONIZATION_BARRIER ThreadBarrier_t;
 #define enterThreadBarrier(barrier)\
     pthread_barrier_wait(barrier)
 
+#define destroyBarrier(barrier)\
+    pthread_barrier_destroy(barrier)
+
 // Exit current thread
 #define exitThread(code)\
     pthread_exit(code)
@@ -167,6 +186,34 @@ typedef SYNCHRONIZATION_BARRIER ThreadBarrier_t;
 // Join thread
 #define joinThread(handle)\
     pthread_join(*handle, NULL)
+
+// Yield thread
+#define yieldThread()\
+    sched_yield()
+
+/* Atomic macros */
+#define atomicIncrement(value)\
+    __atomic_add_fetch(value, 1, __ATOMIC_ACQ_REL)
+
+#define atomicDecrement(value)\
+    __atomic_sub_fetch(value, 1, __ATOMIC_ACQ_REL)
+
+#define atomicLoad(value)\
+    __atomic_load_n(value, __ATOMIC_ACQUIRE)
+
+#define atomicStore(value, newValue)\
+    __atomic_store_n(value, newValue, __ATOMIC_RELEASE)
+
+#define atomicExchange(value, newValue)\
+    __atomic_exchange_n(value, newValue, __ATOMIC_ACQ_REL)
+
+#define atomicAdd64(value, amount)\
+    __atomic_add_fetch(value, amount, __ATOMIC_ACQ_REL)
+
+#define atomicLoad64(value)\
+    __atomic_load_n(value, __ATOMIC_ACQUIRE)
+
+#define THREAD_LOCAL __thread
 #elif __WIN32__
 #define createThread(handle, function, data)\
     *handle=CreateThread(NULL, 0, function, data, 0, NULL)
@@ -202,6 +249,9 @@ typedef SYNCHRONIZATION_BARRIER ThreadBarrier_t;
 #define enterThreadBarrier(barrier)\
     EnterSynchronizationBarrier(barrier, 0)
 
+#define destroyBarrier(barrier)\
+    DeleteSynchronizationBarrier(barrier)
+
 // Exit the current thread with the given code
 #define exitThread(code)\
     ExitThread(code)
@@ -209,6 +259,85 @@ typedef SYNCHRONIZATION_BARRIER ThreadBarrier_t;
 // Wait for the given thread to end
 #define joinThread(handle)\
 	WaitForSingleObject(*handle, INFINITE)
+
+// Give up the rest of this thread's time slice
+#define yieldThread()\
+    SwitchToThread()
+
+/* Atomic macros */
+// the Interlocked functions are full memory barriers
+#define atomicIncrement(value)\
+    InterlockedIncrement((volatile LONG*)(value))
+
+#define atomicDecrement(value)\
+    InterlockedDecrement((volatile LONG*)(value))
+
+#define atomicLoad(value)\
+    InterlockedCompareExchange((volatile LONG*)(value), 0, 0)
+
+#define atomicStore(value, newValue)\
+    InterlockedExchange((volatile LONG*)(value), newValue)
+
+#define atomicExchange(value, newValue)\
+    InterlockedExchange((volatile LONG*)(value), newValue)
+
+#define atomicAdd64(value, amount)\
+    (InterlockedExchangeAdd64((volatile LONG64*)(value), amount) + (amount))
+
+#define atomicLoad64(value)\
+    InterlockedCompareExchange64((volatile LONG64*)(value), 0, 0)
+
+#define THREAD_LOCAL __declspec(thread)
 #endif
 
+/* Lock profiling
+ * Building with PROFILE_LOCKS defined (cmake -DPROFILE_LOCKS=ON) replaces the lock, condition, and
+ * barrier macros above with versions that time every wait (implemented in threads.c). Each lock,
+ * condition, and barrier is named after the expression it was created (or first used) with, minus the
+ * pointer it was reached through - so &engine->renderThreadData.drawLock is renderThreadData.drawLock.
+ *
+ * For each one the profiler counts how many times it was acquired and how many of those had to wait,
+ * keeps a histogram of wait times, and for locks, how long they were held. A report of everything,
+ * ranked by total time spent waiting, is printed when the program exits.
+ */
+#ifdef PROFILE_LOCKS
+// threads.c uses the macros above to do the actual locking
+#ifndef __THREADS_C__
+#undef createLock
+#define createLock(handle)\
+    profileCreateLock(handle, #handle)
+
+#undef createBarrier
+#define createBarrier(barrier, numThreads)\
+    profileCreateBarrier(barrier, numThreads, #barrier)
+
+#undef lockThreadLock
+#define lockThreadLock(lock)\
+    profileLockThreadLock(lock, #lock)
+
+#undef unlockThreadLock
+#define unlockThreadLock(lock)\
+    profileUnlockThreadLock(lock)
+
+#undef waitForConditionSignal
+#define waitForConditionSignal(condition, lock)\
+    profileWaitForConditionSignal(condition, #condition, lock, #lock)
+
+#undef enterThreadBarrier
+#define enterThreadBarrier(barrier)\
+    profileEnterThreadBarrier(barrier, #barrier)
+#endif // __THREADS_C__
+
+void profileCreateLock(ThreadLock_t* lock, const char* name);
+void profileCreateBarrier(ThreadBarrier_t* barrier, int numThreads, const char* name);
+void profileLockThreadLock(ThreadLock_t* lock, const char* name);
+void profileUnlockThreadLock(ThreadLock_t* lock);
+void profileWaitForConditionSignal(ThreadCondition_t* condition, const char* conditionName, ThreadLock_t* lock, const char* lockName);
+void profileEnterThreadBarrier(ThreadBarrier_t* barrier, const char* name);
+
+/* Prints the contention report (called automatically at exit)
+ */
+void printLockProfile();
+#endif // PROFILE_LOCKS
+
 #endif //__THREADS_H__
@@ -0,0 +1,89 @@
+/*
+ * Created by Sean Bowers
+ * CS 2060 section 3, Spring 2018
+ * University of Colorado at Colorado Springs
+ *
+ * Licensed under the MIT License (see LICENSE.txt)
+ */
+/* Trace recorder
+ * Records spans of time on every thread, and writes them out as a Chrome trace (JSON, which
+ * can be opened in chrome://tracing or ui.perfetto.dev) to see how the threads line up.
+ *
+ * A span is a begin event and an end event on the same thread, and spans can nest. Events go
+ * into a ring buffer owned by the thread recording them (made the first time the thread records
+ * anything), so recording one is a clock read and a write to memory no other thread writes -
+ * no locks. Once a ring is full its oldest events are overwritten, so a trace always holds the
+ * most recent events of every thread.
+ *
+ * Nothing is recorded until startTrace() is called. The trace is written by writeTrace(), and
+ * pollTraceSignals() writes it when the program is sent SIGUSR1 (see below).
+ */
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Set by startTrace(), the macros below do nothing until then */
+extern bool traceEnabled;
+
+/* Recording
+ * name should be a string literal (only the pointer is kept), detail is copied (and cut off at
+ * TRACE_DETAIL_LENGTH - 1 characters), and is shown in the span's args.
+ */
+#define TRACE_BEGIN(name)\
+    do { if (traceEnabled) recordTraceEvent(name, NULL); } while (0)
+
+#define TRACE_BEGIN_DETAIL(name, detail)\
+    do { if (traceEnabled) recordTraceEvent(name, detail); } while (0)
+
+// ends the innermost span on this thread
+#define TRACE_END()\
+    do { if (traceEnabled) recordTraceEvent(NULL, NULL); } while (0)
+
+/* Runs the statement (or block) after it in a span, ex. TRACE_SCOPE("load"){ ... }
+ * NOTE: don't return or break out of the block, or the span won't be ended
+ */
+#define TRACE_SCOPE(name)\
+    for (int traceScope_ = ((traceEnabled)? (recordTraceEvent(name, NULL), 1) : 1); traceScope_;\
+         traceScope_ = ((traceEnabled)? (recordTraceEvent(NULL, NULL), 0) : 0))
+
+// Records how long the thread waits on a lock, barrier, or condition, ex. TRACE_WAIT("drawLock", lockThreadLock(&lock))
+#define TRACE_WAIT(name, wait)\
+    do { TRACE_BEGIN("wait: " name); wait; TRACE_END(); } while (0)
+
+#define TRACE_DETAIL_LENGTH 48
+
+/* Starts recording, with a ring of eventsPerThread events for each thread (rounded up to a power of
+ * two, 0 for the default), to be written to path. Should be called before starting other threads.
+ * Returns false if the trace couldn't be started.
+ */
+bool startTrace(const char* path, int eventsPerThread);
+
+/* Writes everything recorded so far to the trace's path. Can be called while threads are still
+ * recording (events overwritten while they're being copied are left out).
+ * Returns false if the file couldn't be written.
+ */
+bool writeTrace();
+
+/* Stops recording and frees every ring (once no other threads are recording)
+ */
+void stopTrace();
+
+/* Names the calling thread in the trace
+ */
+void nameTraceThread(const char* name);
+
+/* Records a begin event (or an end event if name is NULL) on the calling thread, use the macros above
+ */
+void recordTraceEvent(const char* name, const char* detail);
+
+/* Signals
+ * While tracing, SIGUSR1 asks for a snapshot of the trace, and SIGINT and SIGTERM ask the program to
+ * exit so the whole trace can be written (files can't safely be written from a signal handler). This
+ * checks for either: it writes the snapshot if one was asked for, and returns true if the program
+ * should exit. Should be called regularly by one thread (the main loop).
+ */
+bool pollTraceSignals();
+
+#endif //__TRACE_H__
@@ -47,7 +47,7 @@ typedef struct PACK_STRUCT XPChar_s{
 typedef struct PACK_STRUCT XPLayer_s{
     int32_t width; // 32 bits each for width and height of the image
     int32_t height;
-    struct XPChar_s* data; // 2d matrix of character values - stored in column major order
+    struct XPChar_s* data; // 2d matrix of character values - column major in the file, transposed to row major by getXPFile()
 } XPLayer;
 
 #ifdef WIN32
@@ -66,6 +66,11 @@ typedef struct XPFile_s{
 XPFile* getXPFile(const char* filename);
 void freeXPFile(XPFile* file);
 
+/* Returns the unicode character for a CP437 (extended ascii) value, which is how
+ * REXPaint stores characters
+ */
+wchar_t getUTF8CharForCP437Value(int value);
+
 /* Draws a given layer to the given panel
  * clearPanel: if true the panel will be cleared before drawing
  *      so that previous chars won't be visible. If painting a
@@ -40,6 +40,8 @@ const char* introText =
     "Press any key to continue...";
 
 void startGame(Engine* engine, bool skipIntro){
+    TRACE_BEGIN("startGame");
+
     /* Initialize gameState mutex and lock it */
     createLock(&gameStateLock);
     lockThreadLock(&gameStateLock);
@@ -53,13 +55,15 @@ void startGame(Engine* engine, bool skipIntro){
     /* Run a loading animation while setting up the game */
     XPFile* loadingAnimationFrames[4] = {getXPFile("./assets/Loading1.xp"), getXPFile("./assets/Loading2.xp"), getXPFile("./assets/Loading3.xp"), getXPFile("./assets/Loading4.xp")};
     GameObject* loadingAnimation = createAXPSprite(loadingAnimationFrames, 4, 100, 0, 0, 1, engine);
-    centerObject((Object*)loadingAnimation, engine->mainPanel, ((XPSpriteData*)loadingAnimation->userData)->textureData->width, ((XPSpriteData*)loadingAnimation->userData)->textureData->height);
+    centerObject((Object*)loadingAnimation, engine->mainPanel, ((AXPSpriteData*)loadingAnimation->userData)->textureData->width, ((AXPSpriteData*)loadingAnimation->userData)->textureData->height);
     engine->mainPanel->childrenList = (Object*) loadingAnimation;
     // run the loading animation for _at least_ half a second, because it makes the game feel more substantial, and I think the animation is kinda cool :)
-    sleepms(500);
+    TRACE_WAIT("loading animation", waitms(500));
 	
     /* Initialize world state */
-    initializeWorldState();
+    TRACE_SCOPE("initializeWorldState"){
+        initializeWorldState();
+    }
 
     /* Build screens */
     buildTitleScreen();
@@ -82,6 +86,8 @@ void startGame(Engine* engine, bool skipIntro){
 
     /* Use title screen listeners */
     engine->mainPanel->listeners = gameState.titleScreenListenerList;
+
+    TRACE_END();
 }
 
 void cleanUpGame() {
@@ -145,6 +151,10 @@ void initializeWorldState(){
     gameState.fleetStrength = 10;
     gameState.alienStrenth = 100;
     gameState.credits = 0;
+    markChanged(&gameState.shipHealthVersion);
+    markChanged(&gameState.fleetStrengthVersion);
+    markChanged(&gameState.alienStrengthVersion);
+    markChanged(&gameState.creditsVersion);
 }
 
 void runIntroSequence(){
@@ -156,7 +166,7 @@ void runIntroSequence(){
     gameState.engine->mainPanel->childrenList = (Object*) staticAnimation;
     unlockThreadLock(&gameState.engine->renderThreadData.renderLock);
 
-    sleepms(2000);
+    waitms(2000);
 
     /* Replace static animation with static hacked animation, run for 2 seconds */
     XPFile* hackFrames[4] = {getXPFile("./assets/Static_Hack1.xp"), getXPFile("./assets/Static_Hack2.xp"), getXPFile("./assets/Static_Hack3.xp"), getXPFile("./assets/Static_Hack4.xp")};
@@ -165,49 +175,45 @@ void runIntroSequence(){
     lockThreadLock(&gameState.engine->renderThreadData.renderLock);
     gameState.engine->mainPanel->childrenList = (Object*) hackAnimation;
     unlockThreadLock(&gameState.engine->renderThreadData.renderLock);
+    destroyAXPSprite(staticAnimation);
 
-    sleepms(2000);
+    waitms(2000);
 
-	/* Freeze hack animation by setting numFrames to 1 */
-	((AXPSpriteData*)hackAnimation->userData)->numFrames = 1;
+    /* Freeze hack animation by replacing it with a sprite of its first frame */
+    GameObject* hackFrame = createXPSprite(hackFrames[0], 0, 0, 1, gameState.engine);
+
+    lockThreadLock(&gameState.engine->renderThreadData.renderLock);
+    gameState.engine->mainPanel->childrenList = (Object*) hackFrame;
+    unlockThreadLock(&gameState.engine->renderThreadData.renderLock);
+    destroyAXPSprite(hackAnimation);
 
     /* Text crawl */
-    // write our text to the texture buffer of the first frame of the hack animation
-	CursesChar* buffer = ((AXPSpriteData*)hackAnimation->userData)->textureData->frames[0];
-    int bufferHeight = ((AXPSpriteData*)hackAnimation->userData)->textureData->height;
-    int startX = 10; // the text portion is inset into the texture, so we don't want to start at 0,0
-    int startY = 5;
+    // the text portion is inset into the texture, so the crawl starts at 10,5
     int textHeight = 61;
     int textWidth = 236;
 
     // get colors for text
-    //lockThreadLock(&gameState.engine->renderThreadData.drawLock);
     int bg = getBestColor(0, 0, 0, gameState.engine);
     int fg = getBestColor(0, 217, 0, gameState.engine);
     int colorPair = getColorPair(fg, bg, gameState.engine);
-    //unlockThreadLock(&gameState.engine->renderThreadData.drawLock);
 
-    // loop up how many lines of text we're drawing at a time
+    // the text is laid out once, each step only draws the line crawling in at the bottom
+    GameObject* textCrawl = createTextCrawl(introText, COLOR_PAIR(colorPair), textWidth, textHeight, 10, 5, 2, gameState.engine);
+    lockThreadLock(&gameState.engine->renderThreadData.renderLock);
+    gameState.engine->mainPanel->addObject(gameState.engine->mainPanel, (Object*)textCrawl);
+    unlockThreadLock(&gameState.engine->renderThreadData.renderLock);
+
+    // crawl until the first line reaches the top
     for (int lines = 1; lines <= textHeight; lines++){
-        // get the y value we need to start drawing at to print lines to the end of textHeight
-        int y = startY + (textHeight - lines);
-        
-        // blank out the lines from y to startY + textHeight
-        for (int yPos = y; yPos < startY + textHeight; yPos++){
-            for (int x = startX; x < startX + textWidth; x++){
-                CursesChar* charAt = &buffer[(x * bufferHeight) + yPos];
-                charAt->attributes = 0;
-                charAt->character = ' ';
-            }
-        }
-        
-        // and draw the text
-        int linesDrawn = bufferPrintf(buffer, textWidth, bufferHeight, lines, startX, y, COLOR_PAIR(colorPair), "%s", introText);
-        if (linesDrawn == lines){
+        lockThreadLock(&gameState.engine->renderThreadData.renderLock);
+        bool moreText = advanceTextCrawl(textCrawl);
+        unlockThreadLock(&gameState.engine->renderThreadData.renderLock);
+
+        if (moreText){
             // Still printing more, slower print speed
-            sleepms(200);
+            waitms(200);
         } else {
-            sleepms(50);
+            waitms(50);
         }
     }
 
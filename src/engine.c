@@ -10,6 +10,9 @@
 #include <engine.h>
 #ifdef __UNIX__
 #include <unistd.h>
+#include <poll.h>
+#include <errno.h>
+#include <sys/uio.h>
 #elif __WIN32__
 #include <windows.h>
 #endif
@@ -19,71 +22,168 @@
 #include <string.h>
 #include <stdarg.h>
 #include <math.h>
+#include <stdio.h>
+#include <inttypes.h>
 
 int MS_PER_FRAME = 10; // how many milliseconds corrospond to one frame - framerate
+int BUFFER_STRIDE = 0; // cells per row in the stdscr buffers - set in initializeEngine()
+int RENDER_THREADS = 1; // how many threads rasterize each frame - read when the render thread starts
+int OUTPUT_THREADS = 0; // how many threads encode each frame for the terminal (0 = use curses) - read when the drawing thread starts
+volatile int64_t bufferMemory = 0; // bytes held by the engine's buffers (see metrics.h)
+
+/* Tiled rendering state */
+// the tile the current thread is rasterizing (NULL if the thread isn't drawing a tile, in which case nothing is clipped)
+static THREAD_LOCAL RenderTile* currentTile = NULL;
+// the top left of the frame the current tile is in, used to work out where a buffer pointer is in the frame
+static THREAD_LOCAL CursesChar* currentTileFrame = NULL;
+// time the frame currently being rendered was started at (written by the render thread before rasterizing)
+static uint64_t frameTime = 0;
+// number of frames the render thread has started
+static volatile int frameNumber = 0;
+
+/* Draw function names (see setDrawFunctionName()) */
+static ThreadLock_t drawFunctionNamesLock;
+static struct{
+    void (*drawObject)(Object* self, CursesChar* buffer);
+    const char* name;
+} drawFunctionNames[DRAW_PROFILE_TYPES];
+static int numDrawFunctionNames = 0;
+
+/* bufferPrintf() formatting arena */
+// reused by every call on the same thread, and only grown when a longer string is printed
+static THREAD_LOCAL char* printfArena = NULL;
+static THREAD_LOCAL int printfArenaSize = 0;
+
+/* Timer wheel state (see Timer) */
+static Timer* timerWheel[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+// every slot before this time has been run
+static uint64_t timerWheelTime = 0;
+// set once the render thread has stopped, after which timers run as soon as they're scheduled
+static bool timersStopped = false;
+static ThreadLock_t timerWheelLock;
+// threads in waitms() wait for this signal
+static ThreadLock_t timerWaitLock;
+static ThreadCondition_t timerWaitCondition;
 
 /* Engine functions */
 void defaultEngineHandleEvent(Engine* self, Event* event);
 
+/* Color pair tables (see getColorPair()) */
+extern short colorPairForeground[256];
+extern short colorPairBackground[256];
+
+/* Drawing helpers */
+static void paintLetterbox(Engine* engine);
+
+/* Timer helpers */
+static void initializeTimers();
+static void insertTimer(Timer* timer);
+static void runTimers(uint64_t time);
+static void stopTimers();
+
+/* Input latency helpers */
+static void queueHandledInput(Engine* engine, uint64_t timestamp);
+static void takeHandledInputs(Engine* engine, FrameTimings* timings);
+static void recordFrameInputs(Engine* engine, FrameTimings* timings);
+
+/* Debug info helpers */
+static int formatDebugInfo(Engine* engine, char* buffer, size_t size);
+static void updateFrameStats(Engine* engine, FrameTimings* timings);
+static void drawFrameOverlay(Engine* engine, CursesChar* buffer);
+
+/* Tiled rendering helpers */
+static void setupRenderTiles(Engine* engine);
+static void destroyRenderTiles(Engine* engine);
+static void rasterizeTiledFrame(Engine* engine, CursesChar* bufferAtMainPanel);
+static void rasterizeTile(void* data, int index);
+static void drawListEntries(Engine* engine, RenderTile* tile, int row);
+
+/* Draw profile helpers */
+static void prepareDrawProfile(DrawProfile* profile, int numEntries, int numRows);
+static void recordDrawProfile(Engine* engine, FrameTimings* timings);
+static void finishDrawProfile(Engine* engine);
+
+/* Direct output helpers */
+static void setupOutputBands(Engine* engine);
+static void destroyOutputBands(Engine* engine);
+static size_t writeOutputBands(Engine* engine, int drawWidth, int drawHeight, int fd);
+static void diffOutputBand(void* data, int index);
+static void encodeOutputBand(void* data, int index);
+static void claimWorkerJobs(WorkerPool* pool);
+
 /* Thread functions */
 int eventThreadFunction(void* data);
 int renderThreadFunction(void* data);
 int drawingThreadFunction(void* data);
 int renderTimerThreadFunction(void* data);
+int workerPoolThreadFunction(void* data);
 
 /* engine.h implementations */
 /* initializes ncurses, and returns a struct with
  * all information needed to run the engine
  */
 Engine* initializeEngine(int width, int height){
+    return initializeEngineWithBackend(width, height, createTerminalBackend());
+}
+
+Engine* initializeEngineWithBackend(int width, int height, RenderBackend* backend){
     /* Create new engine - freed by destroyEngine() method */
     Engine* newEngine = (Engine*) malloc(sizeof(Engine));
     newEngine->width = width;
     newEngine->height = height;
+    newEngine->backend = backend;
+
+    /* Set up the glyph and style tables used by every buffer */
+    initializeCellTables();
+
+    /* Set up the timer wheel */
+    initializeTimers();
+
+    /* Set up the object type names (before the main panel is created) */
+    createLock(&drawFunctionNamesLock);
 
     /* Initialize ncurses */
-    newEngine->stdscr = initscr();
+    // the backend starts curses, and finds where the viewport goes
+    if (!backend->initialize(backend, newEngine)){
+        // Technically this exit is bad form, but it doesn't do any harm for now.
+        // (the status is non-zero, so scripts running the game can tell it never started)
+        free(newEngine);
+        exit(1);
+    }
     cbreak();
     noecho();
     keypad(stdscr, TRUE);
     curs_set(0);
     start_color();
+    for (int pair = 0; pair < 256; pair++){
+        colorPairForeground[pair] = -1;
+        colorPairBackground[pair] = -1;
+    }
 
     /* Initialize rng */
     srand(time(NULL));
 
-    // Check the size of the terminal window is large enough for a widthxheight window with 1 wide border
-    if (!((COLS > (width + 2)) && (LINES > (height + 2)))){
-        /* We don't have enough space.
-         * Exit for now, a potential solution in the
-         * future might be to attempt to open a new
-         * terminal window to run the game in
-         */
-        endwin();
-        free(newEngine);
-        printf("This terminal window is not big enough to start the engine.\nA size of %dx%d was requested, but only %dx%d is available.\n",
-                width, height, COLS, LINES);
-
-        // Technically this exit is bad form, but it doesn't do any harm for now.
-        exit(0);
-    }
-    
     /* Set up screen buffers */
-    newEngine->stdscrWidth  = COLS;
-    newEngine->stdscrHeight = LINES;
-    newEngine->stdscrBufferSize = newEngine->stdscrWidth * newEngine->stdscrHeight * sizeof(CursesChar);
-    newEngine->stdscrBuffer1 = (CursesChar*) malloc(newEngine->stdscrBufferSize);
-    newEngine->stdscrBuffer2 = (CursesChar*) malloc(newEngine->stdscrBufferSize);
-    newEngine->backgroundBuffer = (CursesChar*) malloc(newEngine->stdscrBufferSize);
+    // buffers are only as big as the viewport
+    // pad each row out to a whole number of cache lines
+    int rowSize = width * sizeof(CursesChar);
+    rowSize = ((rowSize + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE) * CACHE_LINE_SIZE;
+    newEngine->stdscrStride = rowSize / sizeof(CursesChar);
+    BUFFER_STRIDE = newEngine->stdscrStride;
+    newEngine->stdscrBufferSize = newEngine->stdscrStride * height * sizeof(CursesChar);
+    newEngine->stdscrBuffer1 = (CursesChar*) allocateAlignedBuffer(newEngine->stdscrBufferSize);
+    newEngine->stdscrBuffer2 = (CursesChar*) allocateAlignedBuffer(newEngine->stdscrBufferSize);
+    newEngine->backgroundBuffer = (CursesChar*) allocateAlignedBuffer(newEngine->stdscrBufferSize);
+    atomicAdd64(&bufferMemory, 3 * (int64_t)newEngine->stdscrBufferSize);
 
     /* Fill background buffer */
-    // default background char: space with black bg and white fg color
-    for (int x = 0; x < newEngine->stdscrWidth; x++){
-        for (int y = 0; y < newEngine->stdscrHeight; y++){
-            CursesChar* currentChar = &newEngine->backgroundBuffer[(newEngine->stdscrHeight * x) + y];
-            currentChar->attributes = 0;
+    // default background char: space with black bg and white fg color (padding included, so the whole buffer is defined)
+    for (int y = 0; y < height; y++){
+        for (int x = 0; x < newEngine->stdscrStride; x++){
+            CursesChar* currentChar = &newEngine->backgroundBuffer[(newEngine->stdscrStride * y) + x];
+            currentChar->style = 0;
             // clear char array
-            currentChar->character = L' ';
+            currentChar->glyph = getGlyph(L' ');
         }
     }
 
@@ -92,15 +192,20 @@ Engine* initializeEngine(int width, int height){
     memcpy(newEngine->stdscrBuffer2, newEngine->backgroundBuffer, newEngine->stdscrBufferSize);
 
     /* Create the main window */
-    int start_x = (int)((COLS - width) / 2.0f);
-    int start_y = (int)((LINES - height) / 2.0f);
-    // create two wider & two higher, and move up & left one for border
-    newEngine->mainPanel = createPanel(width, height, start_x, start_y, 0);
+    // the main window fills the viewport, so it's at the top left of the buffers
+    newEngine->mainPanel = createPanel(width, height, 0, 0, 0);
     newEngine->activePanel = newEngine->mainPanel;
 
     /* Set engine functions */
     newEngine->handleEvent = defaultEngineHandleEvent;
 
+    /* Set up input latency tracking (before any threads use it) */
+    newEngine->inputLatency.handledHead = 0;
+    newEngine->inputLatency.handledTail = 0;
+    newEngine->inputLatency.dropped = 0;
+    newEngine->inputLatency.lastLatency = 0;
+    clearLatencyHistogram(&newEngine->inputLatency.histogram);
+
     /* Set up threads */
     /* Set up event thread */
     // Locks
@@ -113,6 +218,8 @@ Engine* initializeEngine(int width, int height){
     newEngine->eventThreadData.queuedEvents = NULL;
     newEngine->eventThreadData.queueEnd = &newEngine->eventThreadData.queuedEvents;
     newEngine->eventThreadData.exit = false;
+    newEngine->eventThreadData.queueDepth = 0;
+    memset((void*)newEngine->eventThreadData.eventsDispatched, 0, sizeof(newEngine->eventThreadData.eventsDispatched));
 
     // Start thread
     createThread(&newEngine->eventThread, (ThreadProcess_t)eventThreadFunction, newEngine);
@@ -132,8 +239,24 @@ Engine* initializeEngine(int width, int height){
 
     // Initialize shared resources
     newEngine->renderThreadData.exit = false;
+    newEngine->renderThreadData.renderReady = false;
     newEngine->renderThreadData.fps_calculated = 0.0f;
     newEngine->renderThreadData.framesRendered = 0;
+    newEngine->renderThreadData.rasterMs_calculated = 0.0f;
+    newEngine->renderThreadData.numTiles = 0;
+    newEngine->renderThreadData.numOutputBands = 0;
+    newEngine->renderThreadData.lastFrame = NULL;
+    newEngine->renderThreadData.scrollRegions = false;
+    newEngine->renderThreadData.renderScroll.lines = 0;
+    newEngine->renderThreadData.drawingScroll.lines = 0;
+    newEngine->renderThreadData.drawProfile = NULL;
+    newEngine->renderThreadData.framesEmitted = 0;
+    newEngine->renderThreadData.framesDropped = 0;
+    newEngine->renderThreadData.ttyBytes = 0;
+    memset(&newEngine->renderThreadData.renderTimings, 0, sizeof(FrameTimings));
+    memset(&newEngine->renderThreadData.drawingTimings, 0, sizeof(FrameTimings));
+    memset(&newEngine->renderThreadData.frameStats, 0, sizeof(FrameStats));
+    newEngine->renderThreadData.showOverlay = false;
 	newEngine->renderThreadData.renderBuffer = &newEngine->stdscrBuffer1;
 	newEngine->renderThreadData.drawingBuffer = &newEngine->stdscrBuffer2;
 
@@ -170,10 +293,28 @@ void destroyEngine(Engine* engine){
 	// so if a thread calls destroyEngine they should take care of any objects they've added to mainPanel first.
     destroyPanel(engine->mainPanel);
 
-    free(engine);
+    freeAlignedBuffer(engine->stdscrBuffer1);
+    freeAlignedBuffer(engine->stdscrBuffer2);
+    freeAlignedBuffer(engine->backgroundBuffer);
+    atomicAdd64(&bufferMemory, -3 * (int64_t)engine->stdscrBufferSize);
 
     /* End ncurses mode */
-    endwin();
+    engine->backend->destroy(engine->backend, engine);
+
+    /* Summarize input latency, now that the terminal is back to normal */
+    LatencyHistogram* inputHistogram = &engine->inputLatency.histogram;
+    if (inputHistogram->total > 0){
+        printf("Input latency: %u inputs, p50 %.1fms, p90 %.1fms, p99 %.1fms, max %.1fms\n", inputHistogram->total,
+                getLatencyPercentile(inputHistogram, 0.50) / 1000.0, getLatencyPercentile(inputHistogram, 0.90) / 1000.0,
+                getLatencyPercentile(inputHistogram, 0.99) / 1000.0, inputHistogram->max / 1000.0);
+    }
+
+    /* Write the draw profile's totals */
+    if (engine->renderThreadData.drawProfile != NULL){
+        finishDrawProfile(engine);
+    }
+
+    free(engine);
 }
 
 // center object in panel
@@ -218,8 +359,8 @@ void getAbsolutePosition(Object* parent, int relX, int relY, int* absX, int* abs
 void writewcharToBuffer(CursesChar* buffer, int x, int y, attr_t attr, wchar_t wch){
     /* Call writecharToBuffer with a new CursesChar struct */
     CursesChar ch;
-    ch.attributes = attr;
-    ch.character = wch;
+    ch.style = getCellStyle(attr);
+    ch.glyph = getGlyph(wch);
     writecharToBuffer(buffer, x, y, &ch);
 }
 
@@ -227,40 +368,64 @@ void writewcharToBuffer(CursesChar* buffer, int x, int y, attr_t attr, wchar_t w
 void writecharToBuffer(CursesChar* buffer, int x, int y, CursesChar* ch){
     /* Get CursesChar at (x,y) */
     // Assumes buffer points somewhere inside a stdscr buffer
-    CursesChar* charAt = &buffer[(LINES * x) + y];
+    CursesChar* charAt = &buffer[(BUFFER_STRIDE * y) + x];
+
+    /* Don't draw outside of the current render tile */
+    int startX, startY, endX, endY;
+    if (!clipToRenderTile(charAt, 1, 1, &startX, &startY, &endX, &endY)){
+        return;
+    }
 
     /* Set CursesChar - copy not change address */
     *charAt = *ch;
 }
 
 // printf to buffer
-int bufferPrintf(CursesChar* buffer, int width, int height, int maxHeight, int x, int y, unsigned int attr, const char* format, ...){
+int bufferPrintf(CursesChar* buffer, int width, int stride, int maxHeight, int x, int y, unsigned int attr, const char* format, ...){
     /* Get variadic args */
     va_list args;
     va_start(args, format);
 
     /* Create string */
-    // maximum length of string is width*height (allocate +1 for null terminator)
-    char* str = (char*) malloc(sizeof(char) * ((width * height) + 1));
-    vsnprintf(str, width * height, format, args);
+    // at most maxHeight lines of width chars (plus a newline each) can be printed, so that's the maximum length of string we need
+    // (+1 for null terminator)
+    int maxLength = (width + 1) * maxHeight;
+    va_list retryArgs;
+    va_copy(retryArgs, args);
+    int length = vsnprintf(printfArena, printfArenaSize, format, args);
+    va_end(args);
+    if (length < 0){
+        va_end(retryArgs);
+        return 0;
+    }
+    if (length >= printfArenaSize && printfArenaSize < maxLength + 1){
+        // grow the arena to fit the string (but no more than could be printed) and format it again
+        printfArenaSize = (length < maxLength) ? length + 1 : maxLength + 1;
+        printfArena = (char*) realloc(printfArena, sizeof(char) * printfArenaSize);
+        vsnprintf(printfArena, printfArenaSize, format, retryArgs);
+    }
+    va_end(retryArgs);
 
     /* Draw string to buffer */
+    return bufferPutString(buffer, width, stride, maxHeight, x, y, attr, printfArena);
+}
+
+// print string to buffer
+int bufferPutString(CursesChar* buffer, int width, int stride, int maxHeight, int x, int y, unsigned int attr, const char* str){
+    // every char gets the same style, so only pack it once
+    uint16_t style = getCellStyle(attr);
     int deltaX = 0;
     int deltaY = 0;
-    for (int i = 0; i <= width*height; i++){
-        if (!str[i] || (deltaY >= maxHeight)){
-            // if we've reached a null byte or printed maxHeight lines we're done
-            free(str);
-            return deltaY;
-        } else if (str[i] == '\n') {
+    for (int i = 0; str[i] && (deltaY < maxHeight); i++){
+        if (str[i] == '\n') {
             // move to next line
             deltaX = 0;
             deltaY++;
         } else {
             // print char, advance x by 1, if x == width go to next line
-            CursesChar* charAt = &buffer[((height) * (x + deltaX)) + (y + deltaY)];
-            charAt->attributes = attr;
-            charAt->character = str[i];
+            CursesChar* charAt = &buffer[(stride * (y + deltaY)) + (x + deltaX)];
+            charAt->style = style;
+            charAt->glyph = getGlyph((unsigned char)str[i]);
 
             deltaX++;
             if (deltaX == width){
@@ -270,7 +435,204 @@ int bufferPrintf(CursesChar* buffer, int width, int height, int maxHeight, int x
         }
     }
 
-	return deltaY;
+    return deltaY;
+}
+
+// fill an area of a buffer with one character
+void bufferFill(CursesChar* buffer, int stride, int x, int y, int width, int height, attr_t attr, wchar_t wch){
+    CursesChar fill;
+    fill.style = getCellStyle(attr);
+    fill.glyph = getGlyph(wch);
+    for (int deltaY = 0; deltaY < height; deltaY++){
+        CursesChar* row = &buffer[(stride * (y + deltaY)) + x];
+        for (int deltaX = 0; deltaX < width; deltaX++){
+            row[deltaX] = fill;
+        }
+    }
+}
+
+// Copies a row-major buffer into a stdscr buffer, skipping transparent cells
+void drawBufferToBuffer(CursesChar* buffer, CursesChar* source, int width, int height){
+    // only copy the part of source that lands in the current render tile
+    int startX, startY, endX, endY;
+    if (!clipToRenderTile(buffer, width, height, &startX, &startY, &endX, &endY)){
+        return;
+    }
+
+    for (int y = startY; y < endY; y++){
+        // walk one row of the source and destination at a time - both are contiguous in memory
+        CursesChar* sourceRow = &source[width * y];
+        CursesChar* bufferRow = &buffer[BUFFER_STRIDE * y];
+        for (int x = startX; x < endX; x++){
+            // if char is not transparent (NBSP), draw it
+            if (sourceRow[x].glyph != GLYPH_TRANSPARENT){
+                bufferRow[x] = sourceRow[x];
+            }
+        }
+    }
+}
+
+/* Clips an area of a stdscr buffer to the calling thread's render tile
+ */
+bool clipToRenderTile(CursesChar* buffer, int width, int height, int* startX, int* startY, int* endX, int* endY){
+    *startX = 0;
+    *startY = 0;
+    *endX = width;
+    *endY = height;
+
+    // threads that aren't rasterizing a tile draw everything
+    if (currentTile == NULL){
+        return true;
+    }
+
+    // work out where buffer is in the frame
+    ptrdiff_t offset = buffer - currentTileFrame;
+    int originY = (int)(offset / BUFFER_STRIDE);
+    int originX = (int)(offset % BUFFER_STRIDE);
+    if (originX < 0){
+        originX += BUFFER_STRIDE;
+        originY--;
+    }
+
+    // intersect the area with the tile
+    if (currentTile->x - originX > *startX){
+        *startX = currentTile->x - originX;
+    }
+    if (currentTile->y - originY > *startY){
+        *startY = currentTile->y - originY;
+    }
+    if ((currentTile->x + currentTile->width) - originX < *endX){
+        *endX = (currentTile->x + currentTile->width) - originX;
+    }
+    if ((currentTile->y + currentTile->height) - originY < *endY){
+        *endY = (currentTile->y + currentTile->height) - originY;
+    }
+
+    return (*startX < *endX) && (*startY < *endY);
+}
+
+void scrollFrameArea(Engine* engine, int x, int y, int width, int height, int lines){
+    FrameScroll* scroll = &engine->renderThreadData.renderScroll;
+    if (lines <= 0 || lines >= height){
+        return;
+    }
+
+    if (scroll->lines == 0){
+        scroll->x = x;
+        scroll->y = y;
+        scroll->width = width;
+        scroll->height = height;
+        scroll->lines = lines;
+    } else if (scroll->lines > 0 && scroll->x == x && scroll->y == y && scroll->width == width && scroll->height == height && scroll->lines + lines < height){
+        // scrolled more than once before the frame was rendered
+        scroll->lines += lines;
+    } else {
+        // only one scroll is sent per frame, so the rows are printed normally
+        scroll->lines = -1;
+    }
+}
+
+/* Border templates */
+// built templates for each style, new templates are added to the front
+static BorderTemplate* borderTemplates[BORDER_STYLE_COUNT];
+static ThreadLock_t borderTemplateLock;
+
+// corners and edges of each style: top left, top right, bottom left, bottom right, horizontal, vertical
+static const wchar_t borderCharacters[BORDER_STYLE_COUNT][6] = {
+    {L'┌', L'┐', L'└', L'┘', L'─', L'│'},
+    {L'╔', L'╗', L'╚', L'╝', L'═', L'║'}
+};
+
+const BorderTemplate* getBorderTemplate(BorderStyle style, int width){
+    lockThreadLock(&borderTemplateLock);
+
+    /* Look for an existing template */
+    BorderTemplate* border = borderTemplates[style];
+    while (border != NULL && border->width != width){
+        border = border->next;
+    }
+
+    /* Build one if this is the first border of this style and width */
+    if (border == NULL){
+        const wchar_t* characters = borderCharacters[style];
+        border = (BorderTemplate*) malloc(sizeof(BorderTemplate));
+        border->style = style;
+        border->width = width;
+        border->top = (CursesChar*) malloc(sizeof(CursesChar) * width);
+        border->bottom = (CursesChar*) malloc(sizeof(CursesChar) * width);
+
+        CursesChar horizontal = {getGlyph(characters[4]), 0};
+        for (int x = 0; x < width; x++){
+            border->top[x] = border->bottom[x] = horizontal;
+        }
+        border->top[0].glyph = getGlyph(characters[0]);
+        border->top[width-1].glyph = getGlyph(characters[1]);
+        border->bottom[0].glyph = getGlyph(characters[2]);
+        border->bottom[width-1].glyph = getGlyph(characters[3]);
+        border->left.glyph = border->right.glyph = getGlyph(characters[5]);
+        border->left.style = border->right.style = 0;
+
+        border->next = borderTemplates[style];
+        borderTemplates[style] = border;
+    }
+
+    unlockThreadLock(&borderTemplateLock);
+    return border;
+}
+
+void bufferDrawBorder(CursesChar* buffer, int stride, int x, int y, const BorderTemplate* border, int height){
+    CursesChar* topLeft = &buffer[(stride * y) + x];
+    memcpy(topLeft, border->top, sizeof(CursesChar) * border->width);
+    for (int row = 1; row < height - 1; row++){
+        topLeft[stride * row] = border->left;
+        topLeft[(stride * row) + border->width - 1] = border->right;
+    }
+    memcpy(&topLeft[stride * (height - 1)], border->bottom, sizeof(CursesChar) * border->width);
+}
+
+void drawBorderToBuffer(CursesChar* buffer, const BorderTemplate* border, int height){
+    int startX, startY, endX, endY;
+    if (!clipToRenderTile(buffer, border->width, height, &startX, &startY, &endX, &endY)){
+        return;
+    }
+
+    for (int y = startY; y < endY; y++){
+        CursesChar* bufferRow = &buffer[BUFFER_STRIDE * y];
+        if (y == 0 || y == height - 1){
+            // top and bottom are copied straight from the template
+            const CursesChar* edge = (y == 0) ? border->top : border->bottom;
+            memcpy(&bufferRow[startX], &edge[startX], sizeof(CursesChar) * (endX - startX));
+        } else {
+            // sides, if they're in the tile
+            if (startX == 0){
+                bufferRow[0] = border->left;
+            }
+            if (endX == border->width){
+                bufferRow[border->width - 1] = border->right;
+            }
+        }
+    }
+}
+
+/* Cache line aligned allocations for the stdscr buffers */
+void* allocateAlignedBuffer(size_t size){
+    #ifdef __UNIX__
+        void* buffer = NULL;
+        if (posix_memalign(&buffer, CACHE_LINE_SIZE, size) != 0){
+            return NULL;
+        }
+        return buffer;
+    #elif __WIN32__
+        return _aligned_malloc(size, CACHE_LINE_SIZE);
+    #endif
+}
+
+void freeAlignedBuffer(void* buffer){
+    #ifdef __UNIX__
+        free(buffer);
+    #elif __WIN32__
+        _aligned_free(buffer);
+    #endif
 }
 
 /* Gets a timestamp in milliseconds, from a monotonic clock.
@@ -289,6 +651,121 @@ uint64_t getTimems(){
     #endif
 }
 
+/* Microsecond version of getTimems()
+ */
+uint64_t getTimeus(){
+    #ifdef __UNIX__
+        /* UNIX-like systems */
+        struct timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return ((uint64_t)time.tv_sec * 1000000) + (uint64_t)(time.tv_nsec / 1000);
+    #elif __WIN32__
+        LARGE_INTEGER counter, frequency;
+        QueryPerformanceCounter(&counter);
+        QueryPerformanceFrequency(&frequency);
+        return (uint64_t)((counter.QuadPart * 1000000) / frequency.QuadPart);
+    #endif
+}
+
+/* Nanosecond version of getTimems()
+ */
+uint64_t getTimens(){
+    #ifdef __UNIX__
+        /* UNIX-like systems */
+        struct timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return ((uint64_t)time.tv_sec * 1000000000) + (uint64_t)time.tv_nsec;
+    #elif __WIN32__
+        LARGE_INTEGER counter, frequency;
+        QueryPerformanceCounter(&counter);
+        QueryPerformanceFrequency(&frequency);
+        // split the conversion so the counter can't overflow when multiplied
+        uint64_t seconds = counter.QuadPart / frequency.QuadPart;
+        uint64_t remainder = counter.QuadPart % frequency.QuadPart;
+        return (seconds * 1000000000) + ((remainder * 1000000000) / frequency.QuadPart);
+    #endif
+}
+
+/* Latency histograms */
+void clearLatencyHistogram(LatencyHistogram* histogram){
+    memset(histogram, 0, sizeof(LatencyHistogram));
+}
+
+// Times under 8 get a bucket each, after that each power of two is split into 8 buckets
+static int getHistogramBucket(uint64_t time){
+    if (time < 8){
+        return (int)time;
+    }
+    int highestBit = 3;
+    while ((time >> (highestBit + 1)) != 0){
+        highestBit++;
+    }
+    int bucket = ((highestBit - 2) * 8) + (int)((time >> (highestBit - 3)) & 7);
+    return (bucket < HISTOGRAM_BUCKETS)? bucket : HISTOGRAM_BUCKETS - 1;
+}
+
+// Largest time counted in a bucket
+static uint64_t getHistogramBucketEnd(int bucket){
+    if (bucket < 8){
+        return bucket;
+    }
+    int highestBit = (bucket / 8) + 2;
+    uint64_t width = (uint64_t)1 << (highestBit - 3);
+    return ((8 + (bucket % 8)) * width) + width - 1;
+}
+
+void recordLatency(LatencyHistogram* histogram, uint64_t time){
+    histogram->counts[getHistogramBucket(time)]++;
+    histogram->total++;
+    if (time > histogram->max){
+        histogram->max = time;
+    }
+}
+
+void removeLatency(LatencyHistogram* histogram, uint64_t time){
+    int bucket = getHistogramBucket(time);
+    if (histogram->counts[bucket] > 0){
+        histogram->counts[bucket]--;
+        histogram->total--;
+    }
+}
+
+uint64_t getLatencyPercentile(LatencyHistogram* histogram, double percentile){
+    if (histogram->total == 0){
+        return 0;
+    }
+
+    // nearest rank, counting from 1
+    uint32_t rank = (uint32_t)ceil(percentile * histogram->total);
+    rank = (rank < 1)? 1 : rank;
+    uint32_t counted = 0;
+    for (int bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++){
+        counted += histogram->counts[bucket];
+        if (counted >= rank){
+            uint64_t end = getHistogramBucketEnd(bucket);
+            // the top bucket holds everything past it, and no bucket goes past the largest time
+            return (end < histogram->max && bucket < HISTOGRAM_BUCKETS - 1)? end : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+/* Timestamp of the frame being rendered
+ * Falls back to the current time if nothing has been rendered yet
+ */
+uint64_t getFrameTimems(){
+    if (frameTime == 0){
+        return getTimems();
+    }
+    return frameTime;
+}
+
+/* Number of the frame being rendered
+ */
+int getFrameNumber(){
+    return atomicLoad(&frameNumber);
+}
+
 /* Waits for a given number of milliseconds
  */
 void sleepms(int msec){
@@ -301,6 +778,172 @@ void sleepms(int msec){
 	#endif
 }
 
+/* Timer functions */
+static void initializeTimers(){
+    createLock(&timerWheelLock);
+    createLock(&timerWaitLock);
+    createConditionVariable(&timerWaitCondition);
+
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++){
+        for (int slot = 0; slot < TIMER_WHEEL_SLOTS; slot++){
+            timerWheel[level][slot] = NULL;
+        }
+    }
+    timerWheelTime = getTimems();
+}
+
+// Puts a timer in the slot for its deadline (timerWheelLock must be held)
+static void insertTimer(Timer* timer){
+    // timers which are already late run on the next slot
+    uint64_t deadline = timer->deadline;
+    if (deadline < timerWheelTime){
+        deadline = timerWheelTime;
+    }
+
+    // find the lowest level where the deadline is in the same turn of the wheel above it as the current time
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && (deadline >> (TIMER_WHEEL_BITS * (level + 1))) != (timerWheelTime >> (TIMER_WHEEL_BITS * (level + 1)))){
+        level++;
+    }
+    int slot = (deadline >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+    if ((deadline >> (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) != (timerWheelTime >> (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS))){
+        // too far away for the wheel, so park it in the slot that's reached when the top level wraps around, it's put back in from there
+        slot = 0;
+    }
+
+    /* Add to the front of the slot */
+    Timer** head = &timerWheel[level][slot];
+    timer->next = *head;
+    if (timer->next != NULL){
+        timer->next->previousNext = &timer->next;
+    }
+    timer->previousNext = head;
+    *head = timer;
+    timer->scheduled = true;
+}
+
+// Runs every timer with a deadline up to time (called by the render thread once per frame)
+static void runTimers(uint64_t time){
+    lockThreadLock(&timerWheelLock);
+
+    while (timerWheelTime <= time){
+        /* When a wheel wraps around, move the timers from the next slot of the wheel above down */
+        for (int level = 1; level < TIMER_WHEEL_LEVELS; level++){
+            if (timerWheelTime & (((uint64_t)1 << (TIMER_WHEEL_BITS * level)) - 1)){
+                break;
+            }
+            int slot = (timerWheelTime >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+            Timer* timer = timerWheel[level][slot];
+            timerWheel[level][slot] = NULL;
+            while (timer != NULL){
+                Timer* next = timer->next;
+                insertTimer(timer);
+                timer = next;
+            }
+        }
+
+        /* Run the timers in this slot */
+        int slot = timerWheelTime & (TIMER_WHEEL_SLOTS - 1);
+        Timer* timer = timerWheel[0][slot];
+        timerWheel[0][slot] = NULL;
+        while (timer != NULL){
+            // the callback may free the timer, so get the next one first
+            Timer* next = timer->next;
+            timer->scheduled = false;
+
+            uint64_t runAgain = timer->callback(timer->data, time);
+            if (runAgain != 0){
+                // don't run it again in this slot
+                timer->deadline = (runAgain > timerWheelTime) ? runAgain : timerWheelTime + 1;
+                insertTimer(timer);
+            }
+            timer = next;
+        }
+
+        timerWheelTime++;
+    }
+
+    unlockThreadLock(&timerWheelLock);
+}
+
+// Runs every pending timer once, and any timers scheduled after this right away
+static void stopTimers(){
+    lockThreadLock(&timerWheelLock);
+    timersStopped = true;
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++){
+        for (int slot = 0; slot < TIMER_WHEEL_SLOTS; slot++){
+            Timer* timer = timerWheel[level][slot];
+            timerWheel[level][slot] = NULL;
+            while (timer != NULL){
+                Timer* next = timer->next;
+                timer->scheduled = false;
+                timer->callback(timer->data, timerWheelTime);
+                timer = next;
+            }
+        }
+    }
+    unlockThreadLock(&timerWheelLock);
+}
+
+void scheduleTimer(Timer* timer, uint64_t deadline, pfn_TimerCallback callback, void* data){
+    lockThreadLock(&timerWheelLock);
+
+    /* Take the timer out of its old slot */
+    if (timer->scheduled){
+        *timer->previousNext = timer->next;
+        if (timer->next != NULL){
+            timer->next->previousNext = timer->previousNext;
+        }
+    }
+
+    timer->deadline = deadline;
+    timer->callback = callback;
+    timer->data = data;
+    timer->scheduled = false;
+    if (timersStopped){
+        callback(data, getTimems());
+    } else {
+        insertTimer(timer);
+    }
+
+    unlockThreadLock(&timerWheelLock);
+}
+
+void cancelTimer(Timer* timer){
+    lockThreadLock(&timerWheelLock);
+    if (timer->scheduled){
+        *timer->previousNext = timer->next;
+        if (timer->next != NULL){
+            timer->next->previousNext = timer->previousNext;
+        }
+        timer->scheduled = false;
+    }
+    unlockThreadLock(&timerWheelLock);
+}
+
+// Timer callback for waitms(), data is the flag the waiting thread is checking
+static uint64_t wakeWaitingThread(void* data, uint64_t time){
+    lockThreadLock(&timerWaitLock);
+    *(bool*)data = true;
+    broadcastConditionSignal(&timerWaitCondition);
+    unlockThreadLock(&timerWaitLock);
+    return 0;
+}
+
+void waitms(int msec){
+    bool finished = false;
+    Timer timer;
+    timer.scheduled = false;
+    // scheduled before taking timerWaitLock, since the callback takes it while the timer wheel is locked
+    scheduleTimer(&timer, getTimems() + msec, wakeWaitingThread, &finished);
+
+    lockThreadLock(&timerWaitLock);
+    while (!finished){
+        waitForConditionSignal(&timerWaitCondition, &timerWaitLock);
+    }
+    unlockThreadLock(&timerWaitLock);
+}
+
 /* Color helper functions */
 /* Searches through the available terminal colors for the one that is closest
  * to the given rgb value (by euclidian distance), or if the terminal supports
@@ -359,6 +1002,9 @@ int getBestColor(int r, int g, int b, Engine* engine){
  * one isn't found make a new one at nextColorPair
  */
 int nextColorPair = 1;
+// colors of each pair, kept for direct output (see encodeStyle()) - pair 0 and unused pairs are the terminal's default colors
+short colorPairForeground[256];
+short colorPairBackground[256];
 int getColorPair(int fg, int bg, Engine* engine){
     for (int pair = 0; pair < nextColorPair; pair++){
         /* Get colors in pair */
@@ -376,50 +1022,706 @@ int getColorPair(int fg, int bg, Engine* engine){
      * nextColorPair
      */
     // We need the drawing mutex to use init_pair, since it sends control characters to the terminal
-    lockThreadLock(&engine->renderThreadData.drawLock);
+    TRACE_WAIT("drawLock", lockThreadLock(&engine->renderThreadData.drawLock));
     init_pair(nextColorPair, fg, bg);
     unlockThreadLock(&engine->renderThreadData.drawLock);
+    if (nextColorPair < 256){
+        colorPairForeground[nextColorPair] = fg;
+        colorPairBackground[nextColorPair] = bg;
+    }
     nextColorPair++;
     return nextColorPair - 1;
 }
 
+void resetColors(Engine* engine){
+    lockThreadLock(&engine->renderThreadData.drawLock);
+    nextColor = 16;
+    nextColorPair = 1;
+    for (int pair = 0; pair < 256; pair++){
+        colorPairForeground[pair] = -1;
+        colorPairBackground[pair] = -1;
+    }
+    unlockThreadLock(&engine->renderThreadData.drawLock);
+}
+
+/* Glyph table */
+/* glyphCharacters maps a glyph back to its character, and glyphLookup maps a
+ * character in the basic multilingual plane (anything that fits in 16 bits)
+ * to its glyph, or 0 if it hasn't been added to the table yet. Characters outside
+ * of that range are drawn as '?', since nothing in the game uses them.
+ */
+#define GLYPH_TABLE_SIZE 65536
+wchar_t glyphCharacters[GLYPH_TABLE_SIZE];
+uint16_t glyphLookup[GLYPH_TABLE_SIZE];
+int nextGlyph = 128; // 0-127 are reserved for transparent and ASCII
+ThreadLock_t glyphTableLock;
+
+/* Attribute flags that can be stored in the high 8 bits of a style, in bit order */
+static const attr_t styleAttributeFlags[8] = {A_STANDOUT, A_UNDERLINE, A_REVERSE, A_BLINK, A_DIM, A_BOLD, A_INVIS, A_ITALIC};
+// curses attributes for every combination of the above flags, indexed by the high 8 bits of a style
+attr_t styleFlagAttributes[256];
+
+void initializeCellTables(){
+    createLock(&glyphTableLock);
+    createLock(&borderTemplateLock);
+
+    /* Glyph 0 is transparent, and 1-127 are ASCII */
+    glyphCharacters[GLYPH_TRANSPARENT] = L'\u00A0';
+    for (int i = 1; i < 128; i++){
+        glyphCharacters[i] = (wchar_t)i;
+    }
+
+    /* Pre-compute the flags for each style, so unpacking a style is just two table lookups */
+    for (int flags = 0; flags < 256; flags++){
+        styleFlagAttributes[flags] = 0;
+        for (int flag = 0; flag < 8; flag++){
+            if (flags & (1 << flag)){
+                styleFlagAttributes[flags] |= styleAttributeFlags[flag];
+            }
+        }
+    }
+}
+
+uint16_t getGlyph(wchar_t wch){
+    /* ASCII and NBSP don't need a lookup */
+    if (wch > 0 && wch < 128){
+        return (uint16_t)wch;
+    } else if (wch == L'\u00A0' || wch == 0){
+        return GLYPH_TRANSPARENT;
+    } else if (wch >= GLYPH_TABLE_SIZE || wch < 0){
+        return (uint16_t)'?';
+    }
+
+    /* Most characters will already be in the table, so check without the lock first */
+    uint16_t glyph = glyphLookup[wch];
+    if (glyph != 0){
+        return glyph;
+    }
+
+    /* Add the character to the table
+     * The character is written before the lookup entry, so another thread that
+     * finds the glyph without holding the lock always sees the right character.
+     */
+    lockThreadLock(&glyphTableLock);
+    glyph = glyphLookup[wch];
+    if (glyph == 0){
+        if (nextGlyph < GLYPH_TABLE_SIZE){
+            glyph = nextGlyph;
+            glyphCharacters[glyph] = wch;
+            glyphLookup[wch] = glyph;
+            nextGlyph++;
+        } else {
+            // table full - can only happen if nearly every 16 bit character is used
+            glyph = (uint16_t)'?';
+        }
+    }
+    unlockThreadLock(&glyphTableLock);
+
+    return glyph;
+}
+
+wchar_t getGlyphCharacter(uint16_t glyph){
+    return glyphCharacters[glyph];
+}
+
+/* Cell styles */
+uint16_t getCellStyle(attr_t attr){
+    /* Color pair in the low 8 bits */
+    uint16_t style = PAIR_NUMBER(attr) & 0xFF;
+
+    /* Flags in the high 8 bits */
+    for (int flag = 0; flag < 8; flag++){
+        if (attr & styleAttributeFlags[flag]){
+            style |= (1 << (8 + flag));
+        }
+    }
+
+    return style;
+}
+
+attr_t getCellAttributes(uint16_t style){
+    return COLOR_PAIR(style & 0xFF) | styleFlagAttributes[style >> 8];
+}
+
 /* Engine functions */
 void defaultEngineHandleEvent(Engine* self, Event* event){
     /* Lock the event thread's data lock */
-    lockThreadLock(&self->eventThreadData.dataLock);
+    TRACE_WAIT("event dataLock", lockThreadLock(&self->eventThreadData.dataLock));
 
     /* Add event to the end of the event queue, and update the end pointer */
     *self->eventThreadData.queueEnd = event;
     self->eventThreadData.queueEnd = &event->next;
+    atomicIncrement(&self->eventThreadData.queueDepth);
 
     /* Send new event signal and unlock mutex */
     sendConditionSignal(&self->eventThreadData.eventQueueChanged);
     unlockThreadLock(&self->eventThreadData.dataLock);
 }
 
-/* Thread functions */
-/* Handles the dealing of events sent to the engine. When the engine
- * gets an event (from any thread) it will put the event in the queue
- * and send this thread a signal. This way sending an event to the
- * engine won't block the sending thread while the event is dispatched
- */
-int eventThreadFunction(void* data){
-    // data passed to the thread is a pointer to the engine
-    Engine* engine = (Engine*)data;
+/* Input latency */
+// Called on the event thread once a stamped event has been handled
+static void queueHandledInput(Engine* engine, uint64_t timestamp){
+    struct InputLatency_s* input = &engine->inputLatency;
+    int head = input->handledHead; // only this thread changes the head
+    int next = (head + 1) % INPUT_QUEUE_SIZE;
+    if (next == atomicLoad(&input->handledTail)){
+        // the render thread has fallen far behind, this input won't be measured
+        atomicIncrement(&input->dropped);
+        return;
+    }
+    input->handledInputs[head] = timestamp;
+    atomicStore(&input->handledHead, next);
+}
 
-    // continuously run a loop checking for events
-    while (true){
-        /* Lock the event thread data lock */
-        lockThreadLock(&engine->eventThreadData.dataLock);
+// Called on the render thread as a frame starts, gives it every input handled so far
+static void takeHandledInputs(Engine* engine, FrameTimings* timings){
+    struct InputLatency_s* input = &engine->inputLatency;
+    int tail = input->handledTail; // only this thread changes the tail
+    int head = atomicLoad(&input->handledHead);
+    while (tail != head){
+        if (timings->numInputs < MAX_FRAME_INPUTS){
+            timings->inputTimes[timings->numInputs++] = input->handledInputs[tail];
+        } else {
+            atomicIncrement(&input->dropped);
+        }
+        tail = (tail + 1) % INPUT_QUEUE_SIZE;
+    }
+    atomicStore(&input->handledTail, tail);
+}
 
-        /* Process events if there are any, else wait for new events */
-        if (engine->eventThreadData.queuedEvents != NULL){
-            // move through event queue
-            Event* current = engine->eventThreadData.queuedEvents;
-            Event* previous;
-            while (current != NULL){
-                // send event to the active panel
-                engine->activePanel->objectProperties.handleEvent((Object*)engine->activePanel, current);
+// Called on the drawing thread once a frame has been presented
+static void recordFrameInputs(Engine* engine, FrameTimings* timings){
+    if (timings->numInputs == 0){
+        return;
+    }
+    uint64_t now = getTimeus();
+    struct InputLatency_s* input = &engine->inputLatency;
+    for (int i = 0; i < timings->numInputs; i++){
+        input->lastLatency = now - timings->inputTimes[i];
+        recordLatency(&input->histogram, input->lastLatency);
+    }
+}
+
+/* Debug info */
+// Formats the line of debug info shown at the top left of the terminal (called on the drawing thread)
+static int formatDebugInfo(Engine* engine, char* buffer, size_t size){
+    struct RenderThreadData_s* renderData = &engine->renderThreadData;
+    lockThreadLock(&renderData->dataLock);
+    int length = snprintf(buffer, size, "FPS: %.2f | Raster: %.3fms (%d thread%s)", renderData->fps_calculated, renderData->rasterMs_calculated,
+            renderData->tileWorkers.numWorkers + 1, (renderData->tileWorkers.numWorkers > 0)? "s" : "");
+    unlockThreadLock(&renderData->dataLock);
+
+    // input to screen latency, once there's been any input (the histogram belongs to this thread)
+    LatencyHistogram* inputHistogram = &engine->inputLatency.histogram;
+    if (inputHistogram->total > 0 && length < (int)size){
+        length += snprintf(&buffer[length], size - length, " | Input: %.1fms (p50 %.1f, p99 %.1f)",
+                engine->inputLatency.lastLatency / 1000.0, getLatencyPercentile(inputHistogram, 0.50) / 1000.0,
+                getLatencyPercentile(inputHistogram, 0.99) / 1000.0);
+    }
+    return (length < (int)size)? length : (int)size - 1;
+}
+
+/* Frame stats */
+// Called on the drawing thread once a frame has been presented
+static void updateFrameStats(Engine* engine, FrameTimings* timings){
+    FrameStats* stats = &engine->renderThreadData.frameStats;
+    uint64_t now = getTimeus();
+    if (stats->lastPresentTime == 0){
+        // nothing to measure the first frame against
+        stats->lastPresentTime = now;
+        stats->framesPresented++;
+        atomicStore(&engine->renderThreadData.framesEmitted, (int)stats->framesPresented);
+        return;
+    }
+    uint32_t frameTime = (uint32_t)(now - stats->lastPresentTime);
+    stats->lastPresentTime = now;
+    stats->framesPresented++;
+
+    // a frame that took long enough to cover more than one deadline dropped the frames in between
+    int msPerFrame = getFramePeriod(engine);
+    if (msPerFrame > 0){
+        uint32_t frameBudget = msPerFrame * 1000;
+        uint32_t deadlines = (frameTime + (frameBudget / 2)) / frameBudget;
+        if (deadlines > 1){
+            stats->droppedFrames += deadlines - 1;
+        }
+    }
+    atomicStore(&engine->renderThreadData.framesEmitted, (int)stats->framesPresented);
+    atomicStore(&engine->renderThreadData.framesDropped, (int)stats->droppedFrames);
+
+    /* Take the oldest frame out of the window */
+    int slot = stats->next;
+    if (stats->count == FRAME_STATS_WINDOW){
+        removeLatency(&stats->frameTimeHistogram, stats->frameTimes[slot]);
+        for (int stage = 0; stage < FRAME_STAGE_COUNT; stage++){
+            stats->stageTotals[stage] -= stats->stageTimes[slot][stage];
+        }
+        stats->bytesTotal -= stats->bytes[slot];
+    } else {
+        stats->count++;
+    }
+
+    /* And put this one in */
+    stats->frameTimes[slot] = frameTime;
+    recordLatency(&stats->frameTimeHistogram, frameTime);
+    for (int stage = 0; stage < FRAME_STAGE_COUNT; stage++){
+        stats->stageTimes[slot][stage] = timings->stageTime[stage];
+        stats->stageTotals[stage] += timings->stageTime[stage];
+    }
+    stats->bytes[slot] = (uint32_t)timings->bytes;
+    stats->bytesTotal += stats->bytes[slot];
+    stats->next = (slot + 1) % FRAME_STATS_WINDOW;
+}
+
+/* Frame overlay */
+#define OVERLAY_WIDTH 44
+#define OVERLAY_HISTOGRAM_ROWS 8
+#define OVERLAY_HEIGHT (6 + OVERLAY_HISTOGRAM_ROWS)
+
+void setFrameOverlay(Engine* engine, bool show){
+    atomicStore(&engine->renderThreadData.showOverlay, show);
+}
+
+void toggleFrameOverlay(Engine* engine){
+    // only ever toggled from one thread at a time (the input loop), so load then store is fine
+    setFrameOverlay(engine, !atomicLoad(&engine->renderThreadData.showOverlay));
+}
+
+// Called on the drawing thread (with the draw lock held) before the frame is presented, so the overlay
+// goes through the same diff as the rest of the frame and disappears as soon as it's hidden
+static void drawFrameOverlay(Engine* engine, CursesChar* buffer){
+    FrameStats* stats = &engine->renderThreadData.frameStats;
+    int width = (engine->width < OVERLAY_WIDTH)? engine->width : OVERLAY_WIDTH;
+    // row 0 is covered by the debug info
+    int top = 1;
+    int height = (engine->height - top < OVERLAY_HEIGHT)? engine->height - top : OVERLAY_HEIGHT;
+    if (width <= 0 || height <= 0){
+        return;
+    }
+    int stride = engine->stdscrStride;
+    // only the default color pair is used, since making a new one needs the draw lock (which we're holding)
+    unsigned int textStyle = 0;
+    unsigned int titleStyle = A_REVERSE;
+    bufferFill(buffer, stride, 0, top, width, height, 0, L' ');
+
+    /* Averages over the window */
+    double frames = (stats->count > 0)? stats->count : 1;
+    double stageMs[FRAME_STAGE_COUNT];
+    for (int stage = 0; stage < FRAME_STAGE_COUNT; stage++){
+        stageMs[stage] = stats->stageTotals[stage] / frames / 1000.0;
+    }
+
+    // lines are cut off at the edge of the overlay by bufferPutString()
+    char line[128];
+    int row = top;
+    #define OVERLAY_LINE(style, ...)\
+        if (row < top + height){\
+            snprintf(line, sizeof(line), __VA_ARGS__);\
+            bufferPutString(buffer, width, stride, 1, 0, row++, style, line);\
+        }
+
+    OVERLAY_LINE(titleStyle, " Last %3d frames (times in ms)                ", stats->count);
+    OVERLAY_LINE(textStyle, " p50 %7.2f   p95 %7.2f   p99 %7.2f",
+            getLatencyPercentile(&stats->frameTimeHistogram, 0.50) / 1000.0,
+            getLatencyPercentile(&stats->frameTimeHistogram, 0.95) / 1000.0,
+            getLatencyPercentile(&stats->frameTimeHistogram, 0.99) / 1000.0);
+    OVERLAY_LINE(textStyle, " dropped %-8u bytes/frame %.0f", stats->droppedFrames, stats->bytesTotal / frames);
+    OVERLAY_LINE(textStyle, " compose %6.3f  raster %6.3f  swap  %6.3f", stageMs[FRAME_STAGE_COMPOSE],
+            stageMs[FRAME_STAGE_RASTERIZE], stageMs[FRAME_STAGE_SWAP_WAIT]);
+    OVERLAY_LINE(textStyle, " diff    %6.3f  encode %6.3f  write %6.3f", stageMs[FRAME_STAGE_DIFF],
+            stageMs[FRAME_STAGE_ENCODE], stageMs[FRAME_STAGE_WRITE]);
+
+    /* Frame time histogram */
+    // buckets double from 1ms, the last one holds everything slower
+    int counts[OVERLAY_HISTOGRAM_ROWS] = {0};
+    int most = 1;
+    for (int i = 0; i < stats->count; i++){
+        int bucket = 0;
+        uint32_t limit = 1000;
+        while (stats->frameTimes[i] >= limit && bucket < OVERLAY_HISTOGRAM_ROWS - 1){
+            bucket++;
+            limit *= 2;
+        }
+        counts[bucket]++;
+        most = (counts[bucket] > most)? counts[bucket] : most;
+    }
+    OVERLAY_LINE(titleStyle, " Frame time                                  ");
+    int barWidth = width - 15;
+    for (int bucket = 0; bucket < OVERLAY_HISTOGRAM_ROWS && row < top + height; bucket++){
+        char bar[OVERLAY_WIDTH + 1];
+        int barLength = (barWidth > 0)? (counts[bucket] * barWidth) / most : 0;
+        if (counts[bucket] > 0 && barLength == 0){
+            barLength = 1;
+        }
+        memset(bar, '#', barLength);
+        bar[barLength] = '\0';
+        if (bucket < OVERLAY_HISTOGRAM_ROWS - 1){
+            OVERLAY_LINE(textStyle, " <%4dms %4d %s", 1 << bucket, counts[bucket], bar);
+        } else {
+            OVERLAY_LINE(textStyle, " >%4dms %4d %s", 1 << (bucket - 1), counts[bucket], bar);
+        }
+    }
+    #undef OVERLAY_LINE
+}
+
+/* Draw profile */
+bool startDrawProfile(Engine* engine, const char* path, int budgetms){
+    FILE* file = fopen(path, "w");
+    if (file == NULL){
+        return false;
+    }
+
+    DrawProfile* profile = (DrawProfile*) calloc(1, sizeof(DrawProfile));
+    profile->file = file;
+    profile->budget = (budgetms > 0)? (uint64_t)budgetms * 1000000 : 0;
+    engine->renderThreadData.drawProfile = profile;
+    return true;
+}
+
+void setDrawFunctionName(void (*drawObject)(Object* self, CursesChar* buffer), const char* name){
+    lockThreadLock(&drawFunctionNamesLock);
+    bool found = false;
+    for (int i = 0; i < numDrawFunctionNames; i++){
+        if (drawFunctionNames[i].drawObject == drawObject){
+            found = true;
+            break;
+        }
+    }
+    if (!found && numDrawFunctionNames < DRAW_PROFILE_TYPES){
+        drawFunctionNames[numDrawFunctionNames].drawObject = drawObject;
+        drawFunctionNames[numDrawFunctionNames].name = name;
+        numDrawFunctionNames++;
+    }
+    unlockThreadLock(&drawFunctionNamesLock);
+}
+
+static const char* getDrawFunctionName(const void* drawObject){
+    const char* name = "(unnamed)";
+    lockThreadLock(&drawFunctionNamesLock);
+    for (int i = 0; i < numDrawFunctionNames; i++){
+        if ((const void*)drawFunctionNames[i].drawObject == drawObject){
+            name = drawFunctionNames[i].name;
+            break;
+        }
+    }
+    unlockThreadLock(&drawFunctionNamesLock);
+    return name;
+}
+
+// Makes sure there's a row of entry times for every tile, and clears them for the next frame
+static void prepareDrawProfile(DrawProfile* profile, int numEntries, int numRows){
+    if (numEntries > profile->maxEntries || numRows != profile->numRows){
+        while (profile->maxEntries < numEntries){
+            profile->maxEntries = (profile->maxEntries == 0)? 64 : profile->maxEntries * 2;
+        }
+        profile->numRows = numRows;
+        free(profile->entryTimes);
+        profile->entryTimes = (uint64_t*) malloc(sizeof(uint64_t) * profile->maxEntries * profile->numRows);
+    }
+    memset(profile->entryTimes, 0, sizeof(uint64_t) * profile->maxEntries * profile->numRows);
+}
+
+// Finds the slot for key in an open addressed table of costs (NULL if the table is full)
+static DrawCost* getDrawCost(DrawCost* costs, int size, const void* key){
+    unsigned int start = (unsigned int)(((uintptr_t)key >> 3) * 2654435761u) % size;
+    for (int i = 0; i < size; i++){
+        DrawCost* cost = &costs[(start + i) % size];
+        if (cost->key == key || cost->key == NULL){
+            return cost;
+        }
+    }
+    return NULL;
+}
+
+static void addDrawCost(DrawCost* cost, const void* key, DrawListEntry* entry, uint64_t time){
+    if (cost == NULL){
+        return;
+    }
+    cost->key = key;
+    cost->type = (const void*)entry->object->drawObject;
+    cost->time += time;
+    cost->draws++;
+    cost->x = entry->x;
+    cost->y = entry->y;
+}
+
+// Finds the depth of every entry in the subtree starting at index, and the time it took to draw the whole
+// subtree (the draw list is in the order the tree is walked, see compileDrawList()). Returns the index after it.
+static int measureDrawSubtree(DrawList* list, uint64_t* times, int index, int depth, int* depths, uint64_t* totals){
+    DrawListEntry* entry = &list->entries[index];
+    depths[index] = depth;
+    totals[index] = times[index];
+
+    int next = index + 1;
+    if (entry->panelBackground){
+        Object* current = ((Panel*)entry->object)->childrenList;
+        while (current != NULL && next < list->numEntries){
+            if (current->show){
+                int end = measureDrawSubtree(list, times, next, depth + 1, depths, totals);
+                totals[index] += totals[next];
+                next = end;
+            }
+            current = current->next;
+        }
+    }
+    return next;
+}
+
+static void describeDrawEntry(DrawListEntry* entry, char* label, size_t size){
+    const char* name = getDrawFunctionName((const void*)entry->object->drawObject);
+    if (entry->object->type == OBJECT_PANEL){
+        // panels that are mostly transparent still cost a full copy of their background
+        Panel* panel = (Panel*)entry->object;
+        int cells = panel->width * panel->height;
+        int transparent = 0;
+        for (int i = 0; i < cells; i++){
+            if (panel->backgroundBuffer[i].glyph == GLYPH_TRANSPARENT){
+                transparent++;
+            }
+        }
+        snprintf(label, size, "%s %dx%d, %d%% transparent, at (%d, %d)", name, panel->width, panel->height,
+                (cells > 0)? (100 * transparent) / cells : 0, entry->x, entry->y);
+    } else {
+        snprintf(label, size, "%s at (%d, %d)", name, entry->x, entry->y);
+    }
+}
+
+// Writes the scene tree of the frame just rasterized, with what every node cost to draw
+static void writeDrawSnapshot(Engine* engine, FrameTimings* timings, uint64_t frameCost){
+    DrawProfile* profile = engine->renderThreadData.drawProfile;
+    DrawList* list = &engine->renderThreadData.drawList;
+
+    int* depths = (int*) malloc(sizeof(int) * list->numEntries);
+    uint64_t* totals = (uint64_t*) malloc(sizeof(uint64_t) * list->numEntries);
+    int index = 0;
+    while (index < list->numEntries){
+        index = measureDrawSubtree(list, profile->entryTimes, index, 0, depths, totals);
+    }
+
+    fprintf(profile->file, "Frame %d took %.3fms to compose and rasterize (budget %.3fms)\n", timings->frameNumber,
+            frameCost / 1000000.0, profile->budget / 1000000.0);
+    fprintf(profile->file, "%10s %10s %8s  %s\n", "self ms", "total ms", "% frame", "object");
+    for (int i = 0; i < list->numEntries; i++){
+        char label[128];
+        describeDrawEntry(&list->entries[i], label, sizeof(label));
+        fprintf(profile->file, "%10.3f %10.3f %7.1f%%  %*s%s\n", profile->entryTimes[i] / 1000000.0, totals[i] / 1000000.0,
+                (frameCost > 0)? (100.0 * totals[i]) / frameCost : 0.0, depths[i] * 2, "", label);
+    }
+    fprintf(profile->file, "\n");
+    fflush(profile->file);
+
+    free(depths);
+    free(totals);
+}
+
+// Adds up the entry times of the frame just rasterized, and writes a snapshot if it was over budget
+static void recordDrawProfile(Engine* engine, FrameTimings* timings){
+    DrawProfile* profile = engine->renderThreadData.drawProfile;
+    DrawList* list = &engine->renderThreadData.drawList;
+
+    /* Totals */
+    for (int i = 0; i < list->numEntries; i++){
+        // each tile drew its own part of the entry, the first row ends up with the whole time
+        uint64_t time = profile->entryTimes[i];
+        for (int row = 1; row < profile->numRows; row++){
+            time += profile->entryTimes[(profile->maxEntries * row) + i];
+        }
+        profile->entryTimes[i] = time;
+        profile->totalTime += time;
+
+        DrawListEntry* entry = &list->entries[i];
+        const void* type = (const void*)entry->object->drawObject;
+        addDrawCost(getDrawCost(profile->objects, DRAW_PROFILE_OBJECTS, entry->object), entry->object, entry, time);
+        addDrawCost(getDrawCost(profile->types, DRAW_PROFILE_TYPES, type), type, entry, time);
+    }
+    profile->frames++;
+
+    /* Snapshot slow frames */
+    uint64_t frameCost = ((uint64_t)timings->stageTime[FRAME_STAGE_COMPOSE] + timings->stageTime[FRAME_STAGE_RASTERIZE]) * 1000;
+    if (frameCost > profile->budget){
+        profile->slowFrames++;
+        uint64_t now = getTimems();
+        if (profile->snapshots == 0 || now - profile->lastSnapshot >= 1000){
+            writeDrawSnapshot(engine, timings, frameCost);
+            profile->snapshots++;
+            profile->lastSnapshot = now;
+        }
+    }
+}
+
+static int compareDrawCosts(const void* a, const void* b){
+    const DrawCost* costA = (const DrawCost*)a;
+    const DrawCost* costB = (const DrawCost*)b;
+    if (costA->time == costB->time){
+        return 0;
+    }
+    return (costA->time < costB->time)? 1 : -1;
+}
+
+// Writes the totals of each type and the most expensive objects, and stops profiling
+static void finishDrawProfile(Engine* engine){
+    DrawProfile* profile = engine->renderThreadData.drawProfile;
+    double totalTime = (profile->totalTime > 0)? (double)profile->totalTime : 1.0;
+
+    fprintf(profile->file, "Draw profile: %u frames (%u over budget, %u snapshots), %.3fms drawing per frame\n", profile->frames,
+            profile->slowFrames, profile->snapshots, (profile->frames > 0)? profile->totalTime / 1000000.0 / profile->frames : 0.0);
+
+    /* Types */
+    qsort(profile->types, DRAW_PROFILE_TYPES, sizeof(DrawCost), compareDrawCosts);
+    fprintf(profile->file, "\nBy type:\n%-24s %12s %10s %10s %8s\n", "type", "total ms", "draws", "mean us", "share");
+    for (int i = 0; i < DRAW_PROFILE_TYPES && profile->types[i].key != NULL; i++){
+        DrawCost* cost = &profile->types[i];
+        fprintf(profile->file, "%-24s %12.3f %10u %10.2f %7.1f%%\n", getDrawFunctionName(cost->type), cost->time / 1000000.0,
+                cost->draws, cost->time / 1000.0 / cost->draws, (100.0 * cost->time) / totalTime);
+    }
+
+    /* Objects */
+    qsort(profile->objects, DRAW_PROFILE_OBJECTS, sizeof(DrawCost), compareDrawCosts);
+    fprintf(profile->file, "\nMost expensive objects:\n%-48s %12s %10s %10s %8s\n", "object", "total ms", "draws", "mean us", "share");
+    for (int i = 0; i < 20 && i < DRAW_PROFILE_OBJECTS && profile->objects[i].key != NULL; i++){
+        DrawCost* cost = &profile->objects[i];
+        char label[64];
+        snprintf(label, sizeof(label), "%s at (%d, %d) [%p]", getDrawFunctionName(cost->type), cost->x, cost->y, cost->key);
+        fprintf(profile->file, "%-48s %12.3f %10u %10.2f %7.1f%%\n", label, cost->time / 1000000.0,
+                cost->draws, cost->time / 1000.0 / cost->draws, (100.0 * cost->time) / totalTime);
+    }
+    fclose(profile->file);
+
+    printf("Draw profile: %u frames, %u over budget, %u snapshots, %.3fms drawing per frame\n", profile->frames, profile->slowFrames,
+            profile->snapshots, (profile->frames > 0)? profile->totalTime / 1000000.0 / profile->frames : 0.0);
+
+    free(profile->entryTimes);
+    free(profile);
+    engine->renderThreadData.drawProfile = NULL;
+}
+
+/* Worker pools */
+void createWorkerPool(WorkerPool* pool, int numWorkers){
+    pool->workers = NULL;
+    pool->numWorkers = (numWorkers > 0)? numWorkers : 0;
+    pool->job = NULL;
+    pool->jobData = NULL;
+    pool->numJobs = 0;
+    pool->nextJob = 0;
+    pool->finishedWorkers = 0;
+    pool->exit = false;
+
+    if (pool->numWorkers == 0){
+        return;
+    }
+
+    /* Start workers */
+    pool->workers = (Thread_t*) malloc(sizeof(Thread_t) * pool->numWorkers);
+    createBarrier(&pool->startBarrier, pool->numWorkers + 1);
+    for (int i = 0; i < pool->numWorkers; i++){
+        createThread(&pool->workers[i], (ThreadProcess_t)workerPoolThreadFunction, pool);
+    }
+}
+
+void destroyWorkerPool(WorkerPool* pool){
+    if (pool->numWorkers > 0){
+        // release the workers one last time, with the exit flag set
+        pool->exit = true;
+        enterThreadBarrier(&pool->startBarrier);
+        for (int i = 0; i < pool->numWorkers; i++){
+            joinThread(&pool->workers[i]);
+        }
+    }
+
+    free(pool->workers);
+    pool->workers = NULL;
+    pool->numWorkers = 0;
+}
+
+void runWorkerPool(WorkerPool* pool, pfn_WorkerJob job, void* data, int numJobs){
+    /* Set up the job - the barrier below makes these visible to the workers */
+    pool->job = job;
+    pool->jobData = data;
+    pool->numJobs = numJobs;
+    atomicStore(&pool->nextJob, 0);
+    atomicStore(&pool->finishedWorkers, 0);
+
+    /* Start the workers */
+    if (pool->numWorkers > 0){
+        enterThreadBarrier(&pool->startBarrier);
+    }
+
+    /* Help out, then wait for every worker to run out of indexes */
+    claimWorkerJobs(pool);
+    TRACE_BEGIN("wait: workers");
+    while (atomicLoad(&pool->finishedWorkers) < pool->numWorkers + 1){
+        yieldThread();
+    }
+    TRACE_END();
+}
+
+/* Claims and runs indexes of the pool's current job until there are none left
+ */
+static void claimWorkerJobs(WorkerPool* pool){
+    int index;
+    while ((index = atomicIncrement(&pool->nextJob) - 1) < pool->numJobs){
+        pool->job(pool->jobData, index);
+    }
+
+    // this thread won't touch the job's data again until the next job is started
+    atomicIncrement(&pool->finishedWorkers);
+}
+
+/* Thread functions */
+// Names the span an event is dispatched in
+static EventMetricType getEventMetricType(Event* event){
+    if (event->eventType.mask & EVENT_KEYBOARD){
+        return EVENT_METRIC_KEYBOARD;
+    } else if (event->eventType.mask & EVENT_GAMEMSG){
+        return EVENT_METRIC_GAMEMSG;
+    } else if (event->eventType.mask & EVENT_TIMER){
+        return EVENT_METRIC_TIMER;
+    }
+    return EVENT_METRIC_OTHER;
+}
+
+static const char* getEventTraceName(Event* event){
+    if (event->eventType.mask & EVENT_KEYBOARD){
+        return "dispatch keyboard event";
+    } else if (event->eventType.mask & EVENT_GAMEMSG){
+        return "dispatch game message";
+    } else if (event->eventType.mask & EVENT_TIMER){
+        return "dispatch timer event";
+    }
+    return "dispatch event";
+}
+
+/* Handles the dealing of events sent to the engine. When the engine
+ * gets an event (from any thread) it will put the event in the queue
+ * and send this thread a signal. This way sending an event to the
+ * engine won't block the sending thread while the event is dispatched
+ */
+int eventThreadFunction(void* data){
+    // data passed to the thread is a pointer to the engine
+    Engine* engine = (Engine*)data;
+    nameTraceThread("event");
+
+    // continuously run a loop checking for events
+    while (true){
+        /* Lock the event thread data lock */
+        TRACE_WAIT("event dataLock", lockThreadLock(&engine->eventThreadData.dataLock));
+
+        /* Process events if there are any, else wait for new events */
+        if (engine->eventThreadData.queuedEvents != NULL){
+            // move through event queue
+            Event* current = engine->eventThreadData.queuedEvents;
+            Event* previous;
+            while (current != NULL){
+                // send event to the active panel
+                TRACE_BEGIN(getEventTraceName(current));
+                engine->activePanel->objectProperties.handleEvent((Object*)engine->activePanel, current);
+                TRACE_END();
+                atomicDecrement(&engine->eventThreadData.queueDepth);
+                atomicIncrement(&engine->eventThreadData.eventsDispatched[getEventMetricType(current)]);
+                // once input has been handled, the next frame started can show it
+                if (current->timestamp != 0){
+                    queueHandledInput(engine, current->timestamp);
+                }
 
                 // move up list
                 previous = current;
@@ -433,7 +1735,7 @@ int eventThreadFunction(void* data){
             engine->eventThreadData.queuedEvents = NULL;
             engine->eventThreadData.queueEnd = &engine->eventThreadData.queuedEvents;
         } else {
-            waitForConditionSignal(&engine->eventThreadData.eventQueueChanged, &engine->eventThreadData.dataLock);
+            TRACE_WAIT("events", waitForConditionSignal(&engine->eventThreadData.eventQueueChanged, &engine->eventThreadData.dataLock));
         }
         
         /* Check if we should exit */
@@ -465,45 +1767,95 @@ int renderThreadFunction(void* data){
     // The data passed to this function should be a pointer to the engine
     Engine* engine = (Engine*)data;
     uint64_t lastUpdate = getTimems();
+    uint64_t rasterTime = 0; // microseconds spent rasterizing since the last fps update
+    nameTraceThread("render");
 
     /* Wait for render ready signal */
     lockThreadLock(&engine->renderThreadData.dataLock);
-    waitForConditionSignal(&engine->renderThreadData.engineRenderReady, &engine->renderThreadData.dataLock);
+    // (renderReady is checked first, in case the signal was sent before this thread got here)
+    while (!engine->renderThreadData.renderReady){
+        waitForConditionSignal(&engine->renderThreadData.engineRenderReady, &engine->renderThreadData.dataLock);
+    }
     unlockThreadLock(&engine->renderThreadData.dataLock);
+
+    /* Start tile workers if rendering with more than one thread */
+    setupRenderTiles(engine);
     
     /* Keep looping until exitThread() is called */
     while (true){
         /* Get the render lock */
-        lockThreadLock(&engine->renderThreadData.renderLock);
+        TRACE_WAIT("renderLock", lockThreadLock(&engine->renderThreadData.renderLock));
+
+        /* Start the frame */
+        // sample the clock for everything in this frame, and run any timers that are due
+        frameTime = getTimems();
+        atomicStore(&frameNumber, frameNumber + 1);
+        TRACE_SCOPE("run timers"){
+            runTimers(frameTime);
+        }
 
         /* Render */
-        // Clear the buffer by copying the background buffer to it
-        memcpy(*engine->renderThreadData.renderBuffer, engine->backgroundBuffer, engine->stdscrBufferSize);
+        FrameTimings* timings = &engine->renderThreadData.renderTimings;
+        memset(timings, 0, sizeof(FrameTimings));
+        timings->frameNumber = frameNumber;
+        takeHandledInputs(engine, timings);
+        uint64_t rasterStart = getTimeus();
+        CursesChar* bufferAtMainPanel = &(*engine->renderThreadData.renderBuffer)[(engine->stdscrStride * engine->mainPanel->objectProperties.y) + engine->mainPanel->objectProperties.x];
+        if (engine->renderThreadData.numTiles == 0 && engine->renderThreadData.drawProfile == NULL){
+            // Clear the buffer by copying the background buffer to it
+            TRACE_SCOPE("compose"){
+                memcpy(*engine->renderThreadData.renderBuffer, engine->backgroundBuffer, engine->stdscrBufferSize);
+            }
+            uint64_t composeEnd = getTimeus();
+            timings->stageTime[FRAME_STAGE_COMPOSE] = composeEnd - rasterStart;
+
+            // Render the main panel
+            TRACE_SCOPE("rasterize"){
+                ((Object*)engine->mainPanel)->drawObject((Object*)engine->mainPanel, bufferAtMainPanel);
+            }
+            timings->stageTime[FRAME_STAGE_RASTERIZE] = getTimeus() - composeEnd;
+        } else {
+            // Clear and render each tile in parallel (or the whole frame from the draw list, when profiling draws without tiles)
+            rasterizeTiledFrame(engine, bufferAtMainPanel);
+        }
+        uint64_t rasterEnd = getTimeus();
+        rasterTime += rasterEnd - rasterStart;
 
-        // Render the main panel
-        CursesChar* bufferAtMainPanel = &(*engine->renderThreadData.renderBuffer)[(LINES * engine->mainPanel->objectProperties.x) + engine->mainPanel->objectProperties.y];
-        ((Object*)engine->mainPanel)->drawObject((Object*)engine->mainPanel, bufferAtMainPanel);
+        /* Add up what each object cost to draw (while the render lock keeps the scene from changing) */
+        if (engine->renderThreadData.drawProfile != NULL){
+            TRACE_SCOPE("draw profile"){
+                recordDrawProfile(engine, timings);
+            }
+            // (not counted as waiting for the swap)
+            rasterEnd = getTimeus();
+        }
         
         /* Sync with the draw thread */
-        enterThreadBarrier(&engine->renderThreadData.renderDrawBarrier);
+        TRACE_WAIT("renderDrawBarrier", enterThreadBarrier(&engine->renderThreadData.renderDrawBarrier));
 
         /* Get the draw lock - so we hold both draw and render locks */
-        lockThreadLock(&engine->renderThreadData.drawLock);
+        TRACE_WAIT("drawLock", lockThreadLock(&engine->renderThreadData.drawLock));
+        timings->stageTime[FRAME_STAGE_SWAP_WAIT] = getTimeus() - rasterEnd;
 
         /* Swap buffers */
         CursesChar** tmp = engine->renderThreadData.renderBuffer;
         engine->renderThreadData.renderBuffer = engine->renderThreadData.drawingBuffer;
         engine->renderThreadData.drawingBuffer = tmp;
+        // the scroll hints go with the frame
+        engine->renderThreadData.drawingScroll = engine->renderThreadData.renderScroll;
+        engine->renderThreadData.renderScroll.lines = 0;
+        // and so do the timings, which the drawing thread finishes
+        engine->renderThreadData.drawingTimings = engine->renderThreadData.renderTimings;
 
         /* Release draw and render locks */
         unlockThreadLock(&engine->renderThreadData.renderLock);
         unlockThreadLock(&engine->renderThreadData.drawLock);
 
         /* Sync with the timer and draw thread */
-        enterThreadBarrier(&engine->renderThreadData.timerBarrier);
+        TRACE_WAIT("timerBarrier", enterThreadBarrier(&engine->renderThreadData.timerBarrier));
 
         /* Get data lock */
-        lockThreadLock(&engine->renderThreadData.dataLock);
+        TRACE_WAIT("render dataLock", lockThreadLock(&engine->renderThreadData.dataLock));
 
         /* Update data */
         // increment render count
@@ -518,12 +1870,19 @@ int renderThreadFunction(void* data){
             // 50 frames   | 1000 ms |  = (50 * 1000) / msPassed fps
             // msPassed ms |   1 s   |
             engine->renderThreadData.fps_calculated = (50.0f*1000.0f) / (float)(msPassed);
+
+            // average rasterization time over the same 50 frames
+            engine->renderThreadData.rasterMs_calculated = (float)rasterTime / (50.0f*1000.0f);
+            rasterTime = 0;
         }
 
         /* Check if we should exit */
         if (engine->renderThreadData.exit){
             /* Clean up */
             unlockThreadLock(&engine->renderThreadData.dataLock);
+            destroyRenderTiles(engine);
+            // nothing will advance the timers anymore, so let anything waiting on them go
+            stopTimers();
 
 			/* Join draw thread & timer thread */
 			joinThread(&engine->drawingThread);
@@ -538,32 +1897,687 @@ int renderThreadFunction(void* data){
     }
 }
 
-int drawingThreadFunction(void* data){
+/* Splits the frame into column bands, one per render thread, and starts a worker
+ * thread for every band after the first (the render thread rasterizes tiles too)
+ */
+static void setupRenderTiles(Engine* engine){
+    struct RenderThreadData_s* renderData = &engine->renderThreadData;
+    renderData->tiles = NULL;
+    renderData->numTiles = 0;
+    renderData->drawList.entries = NULL;
+    renderData->drawList.numEntries = 0;
+    renderData->drawList.maxEntries = 0;
+    createWorkerPool(&renderData->tileWorkers, 0);
+
+    if (RENDER_THREADS <= 1){
+        return;
+    }
+
+    // bands are a whole number of cache lines wide, so no two threads ever write to the same cache line
+    int cellsPerLine = CACHE_LINE_SIZE / sizeof(CursesChar);
+    int bandWidth = (engine->width + RENDER_THREADS - 1) / RENDER_THREADS;
+    bandWidth = ((bandWidth + cellsPerLine - 1) / cellsPerLine) * cellsPerLine;
+    int numTiles = (engine->width + bandWidth - 1) / bandWidth;
+    if (numTiles <= 1){
+        return;
+    }
+
+    renderData->numTiles = numTiles;
+    renderData->tiles = (RenderTile*) malloc(sizeof(RenderTile) * renderData->numTiles);
+    for (int i = 0; i < renderData->numTiles; i++){
+        RenderTile* tile = &renderData->tiles[i];
+        tile->x = i * bandWidth;
+        tile->y = 0;
+        tile->width = (tile->x + bandWidth > engine->width)? engine->width - tile->x : bandWidth;
+        tile->height = engine->height;
+    }
+
+    // start workers
+    destroyWorkerPool(&renderData->tileWorkers);
+    createWorkerPool(&renderData->tileWorkers, renderData->numTiles - 1);
+}
+
+/* Stops the tile workers and frees everything allocated by setupRenderTiles()
+ */
+static void destroyRenderTiles(Engine* engine){
+    struct RenderThreadData_s* renderData = &engine->renderThreadData;
+
+    destroyWorkerPool(&renderData->tileWorkers);
+    free(renderData->tiles);
+    atomicAdd64(&bufferMemory, -(int64_t)(sizeof(DrawListEntry) * renderData->drawList.maxEntries));
+    free(renderData->drawList.entries);
+}
+
+/* Renders a frame with the tile workers (called from the render thread)
+ * Without tiles (only when profiling draws), the render thread draws the whole frame from the draw list.
+ */
+static void rasterizeTiledFrame(Engine* engine, CursesChar* bufferAtMainPanel){
+    struct RenderThreadData_s* renderData = &engine->renderThreadData;
+
+    FrameTimings* timings = &renderData->renderTimings;
+
+    /* Compile the scene into a draw list all threads can read from */
+    uint64_t composeStart = getTimeus();
+    renderData->drawList.numEntries = 0;
+    TRACE_SCOPE("compose"){
+        compileDrawList((Object*)engine->mainPanel, bufferAtMainPanel, engine->mainPanel->objectProperties.x, engine->mainPanel->objectProperties.y, &renderData->drawList);
+    }
+    uint64_t composeEnd = getTimeus();
+    timings->stageTime[FRAME_STAGE_COMPOSE] = composeEnd - composeStart;
+
+    /* Rasterize every tile */
+    if (renderData->drawProfile != NULL){
+        prepareDrawProfile(renderData->drawProfile, renderData->drawList.numEntries, (renderData->numTiles > 0)? renderData->numTiles : 1);
+    }
+    TRACE_SCOPE("rasterize"){
+        if (renderData->numTiles > 0){
+            runWorkerPool(&renderData->tileWorkers, rasterizeTile, engine, renderData->numTiles);
+        } else {
+            memcpy(*renderData->renderBuffer, engine->backgroundBuffer, engine->stdscrBufferSize);
+            drawListEntries(engine, NULL, 0);
+        }
+    }
+    timings->stageTime[FRAME_STAGE_RASTERIZE] = getTimeus() - composeEnd;
+}
+
+/* Clears a tile, then draws every entry in the draw list clipped to it
+ * (worker pool job - data is the engine, index is the tile)
+ */
+static void rasterizeTile(void* data, int index){
     Engine* engine = (Engine*)data;
+    RenderTile* tile = &engine->renderThreadData.tiles[index];
+    CursesChar* frame = *engine->renderThreadData.renderBuffer;
+    currentTile = tile;
+    currentTileFrame = frame;
+    TRACE_BEGIN("rasterize tile");
+
+    /* Clear the tile by copying the background buffer to it */
+    for (int y = tile->y; y < tile->y + tile->height; y++){
+        int offset = (engine->stdscrStride * y) + tile->x;
+        memcpy(&frame[offset], &engine->backgroundBuffer[offset], sizeof(CursesChar) * tile->width);
+    }
 
-    /* Wait for render ready signal */
-    lockThreadLock(&engine->renderThreadData.dataLock);
-    waitForConditionSignal(&engine->renderThreadData.engineRenderReady, &engine->renderThreadData.dataLock);
-    unlockThreadLock(&engine->renderThreadData.dataLock);
+    /* Draw entries */
+    drawListEntries(engine, tile, index);
 
-    /* Keep looping until exitThread() is called */
-    while (true){
-        /* Get drawing lock */
-        lockThreadLock(&engine->renderThreadData.drawLock);
+    TRACE_END();
+    currentTile = NULL;
+}
 
-        /* Draw to screen */
-        // move to top left and start adding chars from buffer
-        wmove(engine->stdscr, 0, 0);
-        for (int y = 0; y < engine->stdscrHeight; y++){
-            for (int x = 0; x < engine->stdscrWidth; x++){
-                CursesChar* currentChar = &(*engine->renderThreadData.drawingBuffer)[(engine->stdscrHeight * x) + y];
+/* Draws every entry in the draw list, skipping any that can't reach the tile (if there is one).
+ * When profiling draws, the time each entry takes is added to the given row of the profile's entry times.
+ */
+static void drawListEntries(Engine* engine, RenderTile* tile, int row){
+    DrawList* drawList = &engine->renderThreadData.drawList;
+    DrawProfile* profile = engine->renderThreadData.drawProfile;
+    uint64_t* entryTimes = (profile != NULL)? &profile->entryTimes[profile->maxEntries * row] : NULL;
+
+    for (int i = 0; i < drawList->numEntries; i++){
+        DrawListEntry* entry = &drawList->entries[i];
+
+        if (tile != NULL){
+            // objects draw down and to the right of their position, so anything starting past the tile can be skipped
+            if ((entry->x >= tile->x + tile->width) || (entry->y >= tile->y + tile->height)){
+                continue;
+            }
+            // a panel's size is known, so it can also be skipped if it ends before the tile
+            if (entry->panelBackground){
+                Panel* panel = (Panel*)entry->object;
+                if ((entry->x + panel->width <= tile->x) || (entry->y + panel->height <= tile->y)){
+                    continue;
+                }
+            }
+        }
+
+        uint64_t drawStart = (entryTimes != NULL)? getTimens() : 0;
+        if (entry->panelBackground){
+            Panel* panel = (Panel*)entry->object;
+            drawBufferToBuffer(entry->buffer, panel->backgroundBuffer, panel->width, panel->height);
+        } else {
+            entry->object->drawObject(entry->object, entry->buffer);
+        }
+        if (entryTimes != NULL){
+            entryTimes[i] += getTimens() - drawStart;
+        }
+    }
+}
+
+/* Direct output */
+// longest sequence one cell can be encoded as: an SGR with every attribute and two 256 color codes, and 4 bytes of UTF-8
+#define MAX_CELL_BYTES 48
+// longest cursor movement sequence (at the start of each run of changed cells)
+#define MAX_ROW_BYTES 16
+// changed cells closer together than this are printed as one run, since skipping fewer cells isn't worth moving the cursor
+#define OUTPUT_RUN_GAP 8
+// most runs a row of the given width can be split into
+#define MAX_ROW_RUNS(width) (((width) / (OUTPUT_RUN_GAP + 1)) + 1)
+// longest sequence used to scroll part of the screen
+#define MAX_SCROLL_BYTES 64
+
+// SGR parameter for each style flag (in the same order as styleAttributeFlags - standout is drawn as reverse)
+static const int styleSGRCodes[8] = {7, 4, 7, 5, 2, 1, 8, 3};
+
+// data passed to diffOutputBand() and encodeOutputBand()
+typedef struct OutputFrame_s{
+    Engine* engine;
+    int width, height; // part of the viewport that fits on the terminal
+} OutputFrame;
+
+/* Checks if the terminal's terminfo entry has a string capability
+ */
+static bool hasTerminalCapability(const char* name){
+    char* capability = tigetstr((char*)name);
+    return capability != NULL && capability != (char*)-1;
+}
+
+/* Splits the viewport into bands of rows, one per output thread, and starts a worker
+ * thread for every band after the first (the drawing thread encodes bands too)
+ */
+static void setupOutputBands(Engine* engine){
+    struct RenderThreadData_s* renderData = &engine->renderThreadData;
+    renderData->outputBands = NULL;
+    renderData->numOutputBands = 0;
+    createWorkerPool(&renderData->outputWorkers, 0);
+
+    #ifdef __UNIX__
+    if (OUTPUT_THREADS < 1){
+        return;
+    }
+
+    // scroll hints are only used if the terminal has scroll regions and can scroll by more than one line at a time,
+    // and areas narrower than the viewport also need left and right margins
+    renderData->scrollRegions = hasTerminalCapability("csr") && hasTerminalCapability("indn");
+    renderData->scrollMargins = renderData->scrollRegions && hasTerminalCapability("smglr") && hasTerminalCapability("mgc");
+
+    renderData->numOutputBands = (OUTPUT_THREADS < engine->height)? OUTPUT_THREADS : engine->height;
+    renderData->outputBands = (OutputBand*) malloc(sizeof(OutputBand) * renderData->numOutputBands);
+    renderData->lastFrame = (CursesChar*) malloc(sizeof(CursesChar) * engine->width * engine->height);
+    for (int i = 0; i < renderData->numOutputBands; i++){
+        OutputBand* band = &renderData->outputBands[i];
+        band->y = (engine->height * i) / renderData->numOutputBands;
+        band->height = ((engine->height * (i + 1)) / renderData->numOutputBands) - band->y;
+        // big enough for the worst case, so encoding never has to check for space
+        band->capacity = band->height * ((MAX_ROW_RUNS(engine->width) * MAX_ROW_BYTES) + (engine->width * MAX_CELL_BYTES));
+        band->bytes = (char*) malloc(band->capacity);
+        band->length = 0;
+        band->runs = (OutputRun*) malloc(sizeof(OutputRun) * band->height * MAX_ROW_RUNS(engine->width));
+        band->numRuns = 0;
+        band->changedCells = 0;
+        band->lastRows = &renderData->lastFrame[engine->width * band->y];
+        band->redraw = true;
+        band->redrawFirstRow = false;
+        atomicAdd64(&bufferMemory, (int64_t)band->capacity + (sizeof(OutputRun) * band->height * MAX_ROW_RUNS(engine->width)));
+    }
+    atomicAdd64(&bufferMemory, (int64_t)(sizeof(CursesChar) * engine->width * engine->height));
+
+    // start workers
+    destroyWorkerPool(&renderData->outputWorkers);
+    createWorkerPool(&renderData->outputWorkers, renderData->numOutputBands - 1);
+    #endif
+}
+
+/* Stops the output workers and frees everything allocated by setupOutputBands()
+ */
+static void destroyOutputBands(Engine* engine){
+    struct RenderThreadData_s* renderData = &engine->renderThreadData;
+
+    destroyWorkerPool(&renderData->outputWorkers);
+    for (int i = 0; i < renderData->numOutputBands; i++){
+        OutputBand* band = &renderData->outputBands[i];
+        atomicAdd64(&bufferMemory, -((int64_t)band->capacity + (sizeof(OutputRun) * band->height * MAX_ROW_RUNS(engine->width))));
+        free(band->bytes);
+        free(band->runs);
+    }
+    if (renderData->lastFrame != NULL){
+        atomicAdd64(&bufferMemory, -(int64_t)(sizeof(CursesChar) * engine->width * engine->height));
+    }
+    free(renderData->outputBands);
+    free(renderData->lastFrame);
+    renderData->outputBands = NULL;
+    renderData->lastFrame = NULL;
+    renderData->numOutputBands = 0;
+}
+
+/* Writes a positive number in decimal, returning the end of what was written
+ */
+static char* encodeNumber(char* out, int number){
+    char digits[12];
+    int numDigits = 0;
+    do {
+        digits[numDigits++] = '0' + (number % 10);
+        number /= 10;
+    } while (number > 0);
+    while (numDigits > 0){
+        *out++ = digits[--numDigits];
+    }
+    return out;
+}
+
+/* Writes the SGR parameter for a curses color (base is 30 for foreground, 40 for background)
+ */
+static char* encodeColor(char* out, int color, int base){
+    *out++ = ';';
+    if (color < 0){
+        // terminal default
+        return encodeNumber(out, base + 9);
+    } else if (color < 8){
+        return encodeNumber(out, base + color);
+    } else if (color < 16){
+        // bright colors
+        return encodeNumber(out, base + 60 + (color - 8));
+    }
+    // 256 color palette
+    out = encodeNumber(out, base + 8);
+    *out++ = ';';
+    *out++ = '5';
+    *out++ = ';';
+    return encodeNumber(out, color);
+}
+
+/* Writes an SGR sequence which sets every attribute of a cell style (starting from a reset)
+ */
+static char* encodeStyle(char* out, uint16_t style){
+    int pair = style & 0xFF;
+    int flags = style >> 8;
+
+    *out++ = '\x1b';
+    *out++ = '[';
+    *out++ = '0';
+    for (int bit = 0; bit < 8; bit++){
+        if (flags & (1 << bit)){
+            *out++ = ';';
+            out = encodeNumber(out, styleSGRCodes[bit]);
+        }
+    }
+    out = encodeColor(out, colorPairForeground[pair], 30);
+    out = encodeColor(out, colorPairBackground[pair], 40);
+    *out++ = 'm';
+    return out;
+}
+
+/* Writes a character as UTF-8
+ */
+static char* encodeCharacter(char* out, wchar_t wch){
+    uint32_t ch = (uint32_t)wch;
+    if (ch < 0x80){
+        *out++ = (char)ch;
+    } else if (ch < 0x800){
+        *out++ = (char)(0xC0 | (ch >> 6));
+        *out++ = (char)(0x80 | (ch & 0x3F));
+    } else if (ch < 0x10000){
+        *out++ = (char)(0xE0 | (ch >> 12));
+        *out++ = (char)(0x80 | ((ch >> 6) & 0x3F));
+        *out++ = (char)(0x80 | (ch & 0x3F));
+    } else {
+        *out++ = (char)(0xF0 | (ch >> 18));
+        *out++ = (char)(0x80 | ((ch >> 12) & 0x3F));
+        *out++ = (char)(0x80 | ((ch >> 6) & 0x3F));
+        *out++ = (char)(0x80 | (ch & 0x3F));
+    }
+    return out;
+}
+
+/* Finds the runs of cells in one band of the drawing buffer which changed since they were
+ * last written, and copies the band's rows into lastRows (worker pool job - data is an
+ * OutputFrame, index is the band)
+ */
+static void diffOutputBand(void* data, int index){
+    OutputFrame* frame = (OutputFrame*)data;
+    Engine* engine = frame->engine;
+    OutputBand* band = &engine->renderThreadData.outputBands[index];
+    CursesChar* drawingBuffer = *engine->renderThreadData.drawingBuffer;
+    band->numRuns = 0;
+    band->changedCells = 0;
+
+    int endY = band->y + band->height;
+    if (endY > frame->height){
+        endY = frame->height;
+    }
+    for (int y = band->y; y < endY; y++){
+        CursesChar* currentRow = &drawingBuffer[engine->stdscrStride * y];
+        CursesChar* lastRow = &band->lastRows[engine->width * (y - band->y)];
+        bool redraw = band->redraw || (y == band->y && band->redrawFirstRow);
+
+        // skip rows the terminal already shows
+        if (!redraw && memcmp(currentRow, lastRow, sizeof(CursesChar) * frame->width) == 0){
+            continue;
+        }
+
+        // find the runs of cells that changed
+        int x = 0;
+        while (x < frame->width){
+            int runEnd = frame->width;
+            if (!redraw){
+                // find the next changed cell
+                while (x < frame->width && currentRow[x].glyph == lastRow[x].glyph && currentRow[x].style == lastRow[x].style){
+                    x++;
+                }
+                if (x == frame->width){
+                    break;
+                }
+
+                // the run ends once OUTPUT_RUN_GAP cells in a row haven't changed
+                runEnd = x + 1;
+                for (int scan = x + 1; scan < frame->width && scan - runEnd < OUTPUT_RUN_GAP; scan++){
+                    if (currentRow[scan].glyph != lastRow[scan].glyph || currentRow[scan].style != lastRow[scan].style){
+                        runEnd = scan + 1;
+                    }
+                }
+            }
+
+            OutputRun* run = &band->runs[band->numRuns++];
+            run->x = x;
+            run->y = y;
+            run->width = runEnd - x;
+            band->changedCells += run->width;
+            x = runEnd;
+        }
+        memcpy(lastRow, currentRow, sizeof(CursesChar) * frame->width);
+    }
+
+    band->redraw = false;
+}
+
+/* Encodes the runs diffOutputBand() found in one band of the drawing buffer into escape
+ * sequences and text (worker pool job - data is an OutputFrame, index is the band)
+ */
+static void encodeOutputBand(void* data, int index){
+    OutputFrame* frame = (OutputFrame*)data;
+    Engine* engine = frame->engine;
+    OutputBand* band = &engine->renderThreadData.outputBands[index];
+    CursesChar* drawingBuffer = *engine->renderThreadData.drawingBuffer;
+    char* out = band->bytes;
+
+    // the terminal's SGR state isn't known at the start of a band (the band before it is encoded
+    // separately), so the first cell always sets every attribute
+    int currentStyle = -1;
+
+    for (int i = 0; i < band->numRuns; i++){
+        OutputRun* run = &band->runs[i];
+        CursesChar* currentRow = &drawingBuffer[engine->stdscrStride * run->y];
+
+        // move to the start of the run
+        *out++ = '\x1b';
+        *out++ = '[';
+        out = encodeNumber(out, engine->viewportY + run->y + 1);
+        *out++ = ';';
+        out = encodeNumber(out, engine->viewportX + run->x + 1);
+        *out++ = 'H';
+
+        for (int x = run->x; x < run->x + run->width; x++){
+            if (currentRow[x].style != currentStyle){
+                out = encodeStyle(out, currentRow[x].style);
+                currentStyle = currentRow[x].style;
+            }
+            out = encodeCharacter(out, getGlyphCharacter(currentRow[x].glyph));
+        }
+    }
+
+    band->length = out - band->bytes;
+}
+
+/* Encodes the drawing buffer in parallel, and writes every band (followed by the debug
+ * info line) to fd at once (or only encodes it if fd is -1)
+ * returns: number of bytes encoded
+ */
+static size_t writeOutputBands(Engine* engine, int drawWidth, int drawHeight, int fd){
+    #ifdef __UNIX__
+    struct RenderThreadData_s* renderData = &engine->renderThreadData;
+    FrameTimings* timings = &renderData->drawingTimings;
+    // moving lastFrame to match a scroll is counted as part of the diff
+    uint64_t diffStart = getTimeus();
+
+    /* Scroll the terminal */
+    // the rows the terminal shows are moved the same way, so only cells that don't match after scrolling are printed
+    char scrollSequence[MAX_SCROLL_BYTES];
+    int scrollLength = 0;
+    FrameScroll* scroll = &renderData->drawingScroll;
+    bool fullWidth = (scroll->x == 0 && scroll->width >= drawWidth);
+    bool canScroll = renderData->scrollRegions && (fullWidth || renderData->scrollMargins);
+    if (canScroll && scroll->lines > 0 && scroll->x >= 0 && scroll->y >= 0 && scroll->x + scroll->width <= drawWidth && scroll->y + scroll->height <= drawHeight && !renderData->outputBands[0].redraw){
+        // set the scroll region (and margins if only some columns scroll), scroll it, and reset it to the whole screen
+        char* out = scrollSequence;
+        *out++ = '\x1b';
+        *out++ = '[';
+        out = encodeNumber(out, engine->viewportY + scroll->y + 1);
+        *out++ = ';';
+        out = encodeNumber(out, engine->viewportY + scroll->y + scroll->height);
+        *out++ = 'r';
+        if (!fullWidth){
+            memcpy(out, "\x1b[?69h\x1b[", 8);
+            out += 8;
+            out = encodeNumber(out, engine->viewportX + scroll->x + 1);
+            *out++ = ';';
+            out = encodeNumber(out, engine->viewportX + scroll->x + scroll->width);
+            *out++ = 's';
+        }
+        *out++ = '\x1b';
+        *out++ = '[';
+        out = encodeNumber(out, scroll->lines);
+        *out++ = 'S';
+        if (!fullWidth){
+            memcpy(out, "\x1b[?69l", 6);
+            out += 6;
+        }
+        *out++ = '\x1b';
+        *out++ = '[';
+        *out++ = 'r';
+        scrollLength = out - scrollSequence;
+
+        // move what the terminal shows the same way, rows that scrolled in are blank
+        // (full width scrolls move the whole row, including anything past the edge of the terminal)
+        int left = (fullWidth)? 0: scroll->x;
+        int width = (fullWidth)? engine->width: scroll->width;
+        CursesChar blank = {getGlyph(L' '), 0};
+        for (int row = 0; row < scroll->height; row++){
+            CursesChar* lastRow = &renderData->lastFrame[(engine->width * (scroll->y + row)) + left];
+            if (row + scroll->lines < scroll->height){
+                memcpy(lastRow, &lastRow[engine->width * scroll->lines], sizeof(CursesChar) * width);
+            } else {
+                for (int x = 0; x < width; x++){
+                    lastRow[x] = blank;
+                }
+            }
+        }
+    }
+
+    /* Diff and encode bands */
+    // the debug info line is printed over the top row of the viewport if there's no room above it, so
+    // what the terminal shows there isn't what lastFrame says (and has to be written again every frame)
+    renderData->outputBands[0].redrawFirstRow = (engine->viewportY == 0);
+    OutputFrame frame;
+    frame.engine = engine;
+    frame.width = drawWidth;
+    frame.height = drawHeight;
+    TRACE_SCOPE("diff"){
+        runWorkerPool(&renderData->outputWorkers, diffOutputBand, &frame, renderData->numOutputBands);
+    }
+    uint64_t diffEnd = getTimeus();
+    TRACE_SCOPE("encode"){
+        runWorkerPool(&renderData->outputWorkers, encodeOutputBand, &frame, renderData->numOutputBands);
+    }
+    timings->stageTime[FRAME_STAGE_DIFF] = diffEnd - diffStart;
+    timings->stageTime[FRAME_STAGE_ENCODE] = getTimeus() - diffEnd;
+
+    /* Debug info at top left (this also leaves the terminal with its attributes reset) */
+    char debugInfo[192] = "\x1b[1;1H\x1b[0m";
+    int debugInfoLength = strlen(debugInfo);
+    debugInfoLength += formatDebugInfo(engine, &debugInfo[debugInfoLength], sizeof(debugInfo) - debugInfoLength - 3);
+    if (engine->viewportY > 0){
+        // clear the rest of the line, in case the last one was longer (over the viewport the top row is written again instead)
+        memcpy(&debugInfo[debugInfoLength], "\x1b[K", 3);
+        debugInfoLength += 3;
+    }
+
+    /* Write everything with one system call (more if the terminal doesn't take it all at once) */
+    struct iovec output[renderData->numOutputBands + 2];
+    output[0].iov_base = scrollSequence;
+    output[0].iov_len = scrollLength;
+    for (int i = 0; i < renderData->numOutputBands; i++){
+        output[i + 1].iov_base = renderData->outputBands[i].bytes;
+        output[i + 1].iov_len = renderData->outputBands[i].length;
+    }
+    output[renderData->numOutputBands + 1].iov_base = debugInfo;
+    output[renderData->numOutputBands + 1].iov_len = debugInfoLength;
+
+    size_t length = 0;
+    for (int i = 0; i < renderData->numOutputBands + 2; i++){
+        length += output[i].iov_len;
+    }
+    timings->changedCells = 0;
+    for (int i = 0; i < renderData->numOutputBands; i++){
+        timings->changedCells += renderData->outputBands[i].changedCells;
+    }
+    timings->bytes = length;
+    if (fd < 0){
+        return length;
+    }
+
+    uint64_t writeStart = getTimeus();
+    TRACE_BEGIN("write");
+    struct iovec* remaining = output;
+    int remainingCount = renderData->numOutputBands + 2;
+    while (remainingCount > 0){
+        ssize_t written = writev(fd, remaining, remainingCount);
+        if (written < 0){
+            if (errno == EINTR){
+                continue;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK){
+                // the terminal isn't taking any more right now, wait until it can
+                struct pollfd writable = {fd, POLLOUT, 0};
+                poll(&writable, 1, 10);
+                continue;
+            }
+            // give up on this frame - the diff already counts it as written, so the next frame has to redraw everything
+            for (int i = 0; i < renderData->numOutputBands; i++){
+                renderData->outputBands[i].redraw = true;
+            }
+            break;
+        }
+        // skip past whatever was written
+        while (remainingCount > 0 && (size_t)written >= remaining->iov_len){
+            written -= remaining->iov_len;
+            remaining++;
+            remainingCount--;
+        }
+        if (remainingCount > 0){
+            remaining->iov_base = (char*)remaining->iov_base + written;
+            remaining->iov_len -= written;
+        }
+    }
+    TRACE_END();
+    timings->stageTime[FRAME_STAGE_WRITE] = getTimeus() - writeStart;
+    return length;
+    #else
+    return 0;
+    #endif
+}
+
+/* Recenters the viewport on the terminal and clears everything outside of it.
+ * Called by the drawing thread (with the draw lock held) on the first frame, and
+ * whenever the terminal has been resized.
+ */
+static void paintLetterbox(Engine* engine){
+    engine->stdscrWidth = COLS;
+    engine->stdscrHeight = LINES;
+
+    // center the viewport, or pin it to the top left if the terminal has been made too small
+    engine->viewportX = (COLS > engine->width)? (int)((COLS - engine->width) / 2.0f) : 0;
+    engine->viewportY = (LINES > engine->height)? (int)((LINES - engine->height) / 2.0f) : 0;
+
+    // blank the whole screen - the viewport is redrawn over it right after this
+    werase(engine->stdscr);
+}
+
+/* Render backends */
+int getFramePeriod(Engine* engine){
+    return (engine->backend->msPerFrame >= 0)? engine->backend->msPerFrame : MS_PER_FRAME;
+}
+
+/* Terminal backend */
+static bool initializeTerminalBackend(RenderBackend* self, Engine* engine){
+    engine->stdscr = initscr();
+
+    // Check the size of the terminal window is large enough for a widthxheight window with 1 wide border
+    if (!((COLS > (engine->width + 2)) && (LINES > (engine->height + 2)))){
+        /* We don't have enough space.
+         * Exit for now, a potential solution in the
+         * future might be to attempt to open a new
+         * terminal window to run the game in
+         */
+        endwin();
+        printf("This terminal window is not big enough to start the engine.\nA size of %dx%d was requested, but only %dx%d is available.\n",
+                engine->width, engine->height, COLS, LINES);
+        return false;
+    }
+
+    // the viewport is centered on the terminal
+    engine->stdscrWidth  = COLS;
+    engine->stdscrHeight = LINES;
+    engine->viewportX = (int)((COLS - engine->width) / 2.0f);
+    engine->viewportY = (int)((LINES - engine->height) / 2.0f);
+    return true;
+}
+
+static void startTerminalBackend(RenderBackend* self, Engine* engine){
+    /* Start output workers if printing frames directly */
+    setupOutputBands(engine);
+
+    // the letterbox is painted on the first frame
+    engine->stdscrWidth = 0;
+}
+
+static void presentTerminalFrame(RenderBackend* self, Engine* engine){
+    /* Paint the letterbox around the viewport if needed */
+    // COLS and LINES are updated by curses when it handles a resize (in getch)
+    if (engine->stdscrWidth != COLS || engine->stdscrHeight != LINES){
+        paintLetterbox(engine);
+
+        // when printing directly curses doesn't know what's on the screen, so have it clear everything right away
+        if (engine->renderThreadData.numOutputBands > 0){
+            clearok(curscr, TRUE);
+            wrefresh(engine->stdscr);
+            for (int i = 0; i < engine->renderThreadData.numOutputBands; i++){
+                engine->renderThreadData.outputBands[i].redraw = true;
+            }
+        }
+    }
+
+    /* Draw to screen */
+    // only print the part of the viewport that fits on the terminal
+    int drawWidth = engine->width;
+    int drawHeight = engine->height;
+    if (engine->viewportX + drawWidth > engine->stdscrWidth){
+        drawWidth = engine->stdscrWidth - engine->viewportX;
+    }
+    if (engine->viewportY + drawHeight > engine->stdscrHeight){
+        drawHeight = engine->stdscrHeight - engine->viewportY;
+    }
+    if (engine->renderThreadData.numOutputBands > 0){
+        // encode and write the frame ourselves
+        #ifdef __UNIX__
+        atomicAdd64(&engine->renderThreadData.ttyBytes, (int64_t)writeOutputBands(engine, drawWidth, drawHeight, STDOUT_FILENO));
+        #endif
+    } else {
+        FrameTimings* timings = &engine->renderThreadData.drawingTimings;
+        uint64_t encodeStart = getTimeus();
+        TRACE_BEGIN("encode");
+        for (int y = 0; y < drawHeight; y++){
+            // move to the start of this row of the viewport and start adding chars from buffer
+            wmove(engine->stdscr, engine->viewportY + y, engine->viewportX);
+            // rows are contiguous, so walk each one straight through
+            CursesChar* currentRow = &(*engine->renderThreadData.drawingBuffer)[engine->stdscrStride * y];
+            for (int x = 0; x < drawWidth; x++){
+                CursesChar* currentChar = &currentRow[x];
+                // expand the packed cell back into a curses character
                 #ifdef __WIN32__
-				cchar_t pdcursesChar = currentChar->character | currentChar->attributes;
+                cchar_t pdcursesChar = getGlyphCharacter(currentChar->glyph) | getCellAttributes(currentChar->style);
                 wadd_wch(engine->stdscr, &pdcursesChar);
                 #elif __UNIX__
-                cchar_t ncursesChar;
-                ncursesChar.attr = currentChar->attributes;
-                ncursesChar.chars[0] = currentChar->character;
+                // (zeroed first, so the extended color doesn't override the pair in attr)
+                cchar_t ncursesChar = {0};
+                ncursesChar.attr = getCellAttributes(currentChar->style);
+                ncursesChar.chars[0] = getGlyphCharacter(currentChar->glyph);
                 ncursesChar.chars[1] = 0;
                 wadd_wch(engine->stdscr, &ncursesChar);
                 #endif
@@ -571,29 +2585,303 @@ int drawingThreadFunction(void* data){
         }
 
         // Print debug info at top left
+        char debugInfo[192];
+        formatDebugInfo(engine, debugInfo, sizeof(debugInfo));
         wmove(engine->stdscr, 0,0);
-		lockThreadLock(&engine->renderThreadData.dataLock);
-        wprintw(engine->stdscr, "FPS: %.2f", engine->renderThreadData.fps_calculated);
-		unlockThreadLock(&engine->renderThreadData.dataLock);
+        waddstr(engine->stdscr, debugInfo);
+        TRACE_END();
+        uint64_t writeStart = getTimeus();
+        timings->stageTime[FRAME_STAGE_ENCODE] = writeStart - encodeStart;
 
-        wrefresh(engine->stdscr);
+        TRACE_SCOPE("write"){
+            wrefresh(engine->stdscr);
+        }
+        timings->stageTime[FRAME_STAGE_WRITE] = getTimeus() - writeStart;
+    }
+}
+
+static void stopTerminalBackend(RenderBackend* self, Engine* engine){
+    destroyOutputBands(engine);
+}
+
+static void destroyTerminalBackend(RenderBackend* self, Engine* engine){
+    endwin();
+    free(self);
+}
+
+RenderBackend* createTerminalBackend(){
+    RenderBackend* backend = (RenderBackend*) malloc(sizeof(RenderBackend));
+    backend->initialize = initializeTerminalBackend;
+    backend->start = startTerminalBackend;
+    backend->presentFrame = presentTerminalFrame;
+    backend->stop = stopTerminalBackend;
+    backend->destroy = destroyTerminalBackend;
+    backend->msPerFrame = -1;
+    backend->data = NULL;
+    return backend;
+}
+
+/* Headless backend */
+// terminal curses is set up as, so colors don't depend on the machine
+#define HEADLESS_TERM "xterm-256color"
+
+typedef struct HeadlessBackendData_s{
+    // where frames and checksums are written (NULL if they aren't)
+    const char* framePath;
+    const char* checksumPath;
+    FILE* frameFile;
+    FILE* checksumFile;
+    // one row of a frame as UTF-8, for frame dumps
+    char* rowText;
+
+    #ifdef __UNIX__
+    // curses reads from and writes to /dev/null
+    SCREEN* screen;
+    FILE* nullInput;
+    FILE* nullOutput;
+    #endif
+
+    // counted while running, for the summary
+    unsigned int framesPresented;
+    uint64_t startTime; // microseconds
+    uint64_t bytesEncoded;
+} HeadlessBackendData;
+
+// Closes whatever initializeHeadlessBackend() opened before it failed
+static void closeHeadlessFiles(HeadlessBackendData* headless){
+    if (headless->frameFile != NULL){
+        fclose(headless->frameFile);
+        headless->frameFile = NULL;
+    }
+    if (headless->checksumFile != NULL){
+        fclose(headless->checksumFile);
+        headless->checksumFile = NULL;
+    }
+    #ifdef __UNIX__
+    if (headless->nullInput != NULL){
+        fclose(headless->nullInput);
+        headless->nullInput = NULL;
+    }
+    if (headless->nullOutput != NULL){
+        fclose(headless->nullOutput);
+        headless->nullOutput = NULL;
+    }
+    #endif
+}
+
+static bool initializeHeadlessBackend(RenderBackend* self, Engine* engine){
+    HeadlessBackendData* headless = (HeadlessBackendData*)self->data;
+
+    /* Open output files */
+    headless->frameFile = NULL;
+    headless->checksumFile = NULL;
+    #ifdef __UNIX__
+    headless->nullInput = NULL;
+    headless->nullOutput = NULL;
+    #endif
+    if (headless->framePath != NULL && (headless->frameFile = fopen(headless->framePath, "w")) == NULL){
+        printf("Could not open %s to write frames to.\n", headless->framePath);
+        closeHeadlessFiles(headless);
+        return false;
+    }
+    if (headless->checksumPath != NULL && (headless->checksumFile = fopen(headless->checksumPath, "w")) == NULL){
+        printf("Could not open %s to write checksums to.\n", headless->checksumPath);
+        closeHeadlessFiles(headless);
+        return false;
+    }
+
+    /* Start curses with no terminal */
+    #ifdef __UNIX__
+    headless->nullInput = fopen("/dev/null", "r");
+    headless->nullOutput = fopen("/dev/null", "w");
+    if (headless->nullInput == NULL || headless->nullOutput == NULL){
+        printf("Could not open /dev/null for headless rendering.\n");
+        closeHeadlessFiles(headless);
+        return false;
+    }
+    headless->screen = newterm(HEADLESS_TERM, headless->nullOutput, headless->nullInput);
+    if (headless->screen == NULL){
+        printf("Could not start curses as %s for headless rendering.\n", HEADLESS_TERM);
+        closeHeadlessFiles(headless);
+        return false;
+    }
+    #elif __WIN32__
+    initscr();
+    #endif
+    engine->stdscr = stdscr;
+    // 3 bytes per character is enough for anything in the glyph table, plus the newline
+    headless->rowText = (char*) malloc((engine->width * 3) + 1);
+
+    // the screen is exactly the viewport
+    resize_term(engine->height, engine->width);
+    engine->stdscrWidth = engine->width;
+    engine->stdscrHeight = engine->height;
+    engine->viewportX = 0;
+    engine->viewportY = 0;
+    return true;
+}
+
+static void startHeadlessBackend(RenderBackend* self, Engine* engine){
+    HeadlessBackendData* headless = (HeadlessBackendData*)self->data;
+
+    /* Start output workers if encoding frames */
+    setupOutputBands(engine);
+
+    headless->framesPresented = 0;
+    headless->bytesEncoded = 0;
+    headless->startTime = getTimeus();
+}
+
+static void presentHeadlessFrame(RenderBackend* self, Engine* engine){
+    HeadlessBackendData* headless = (HeadlessBackendData*)self->data;
+    CursesChar* frame = *engine->renderThreadData.drawingBuffer;
+    headless->framesPresented++;
+
+    // encode the frame the same way as for a terminal, but don't write it anywhere
+    if (engine->renderThreadData.numOutputBands > 0){
+        headless->bytesEncoded += writeOutputBands(engine, engine->width, engine->height, -1);
+    }
+
+    if (headless->frameFile == NULL && headless->checksumFile == NULL){
+        return;
+    }
+    uint64_t checksum = checksumBuffer(frame, engine->width, engine->height);
+
+    if (headless->checksumFile != NULL){
+        fprintf(headless->checksumFile, "%u %016" PRIx64 "\n", headless->framesPresented, checksum);
+    }
+    if (headless->frameFile != NULL){
+        fprintf(headless->frameFile, "frame %u %016" PRIx64 "\n", headless->framesPresented, checksum);
+        for (int y = 0; y < engine->height; y++){
+            CursesChar* currentRow = &frame[engine->stdscrStride * y];
+            char* out = headless->rowText;
+            for (int x = 0; x < engine->width; x++){
+                out = encodeCharacter(out, getGlyphCharacter(currentRow[x].glyph));
+            }
+            *out++ = '\n';
+            fwrite(headless->rowText, 1, out - headless->rowText, headless->frameFile);
+        }
+    }
+}
+
+static void stopHeadlessBackend(RenderBackend* self, Engine* engine){
+    destroyOutputBands(engine);
+}
+
+static void destroyHeadlessBackend(RenderBackend* self, Engine* engine){
+    HeadlessBackendData* headless = (HeadlessBackendData*)self->data;
+
+    /* End curses */
+    endwin();
+    #ifdef __UNIX__
+    delscreen(headless->screen);
+    fclose(headless->nullInput);
+    fclose(headless->nullOutput);
+    #endif
+
+    /* Print summary */
+    float seconds = (float)(getTimeus() - headless->startTime) / 1000000.0f;
+    printf("Headless: %u frames in %.2fs (%.2f fps)", headless->framesPresented, seconds,
+            (seconds > 0.0f)? (float)headless->framesPresented / seconds : 0.0f);
+    if (headless->bytesEncoded > 0){
+        printf(", %.0f bytes encoded per frame", (double)headless->bytesEncoded / headless->framesPresented);
+    }
+    printf("\n");
+
+    /* Free everything */
+    if (headless->frameFile != NULL){
+        fclose(headless->frameFile);
+    }
+    if (headless->checksumFile != NULL){
+        fclose(headless->checksumFile);
+    }
+    free(headless->rowText);
+    free(headless);
+    free(self);
+}
+
+RenderBackend* createHeadlessBackend(const char* framePath, const char* checksumPath, int msPerFrame){
+    HeadlessBackendData* headless = (HeadlessBackendData*) malloc(sizeof(HeadlessBackendData));
+    headless->framePath = framePath;
+    headless->checksumPath = checksumPath;
+
+    RenderBackend* backend = (RenderBackend*) malloc(sizeof(RenderBackend));
+    backend->initialize = initializeHeadlessBackend;
+    backend->start = startHeadlessBackend;
+    backend->presentFrame = presentHeadlessFrame;
+    backend->stop = stopHeadlessBackend;
+    backend->destroy = destroyHeadlessBackend;
+    backend->msPerFrame = msPerFrame;
+    backend->data = headless;
+    return backend;
+}
+
+/* Frame checksums (FNV-1a) */
+uint64_t checksumBuffer(CursesChar* buffer, int width, int height){
+    uint64_t hash = 14695981039346656037ULL;
+    for (int y = 0; y < height; y++){
+        CursesChar* currentRow = &buffer[BUFFER_STRIDE * y];
+        for (int x = 0; x < width; x++){
+            // 4 bytes of character, then 2 of style
+            uint64_t cell = ((uint64_t)(uint32_t)getGlyphCharacter(currentRow[x].glyph) << 16) | currentRow[x].style;
+            for (int byte = 0; byte < 6; byte++){
+                hash ^= (cell >> (byte * 8)) & 0xFF;
+                hash *= 1099511628211ULL;
+            }
+        }
+    }
+    return hash;
+}
+
+int drawingThreadFunction(void* data){
+    Engine* engine = (Engine*)data;
+
+    /* Wait for render ready signal */
+    lockThreadLock(&engine->renderThreadData.dataLock);
+    // (renderReady is checked first, in case the signal was sent before this thread got here)
+    while (!engine->renderThreadData.renderReady){
+        waitForConditionSignal(&engine->renderThreadData.engineRenderReady, &engine->renderThreadData.dataLock);
+    }
+    unlockThreadLock(&engine->renderThreadData.dataLock);
+
+    /* Start the backend */
+    nameTraceThread("draw");
+    engine->backend->start(engine->backend, engine);
+
+    /* Keep looping until exitThread() is called */
+    while (true){
+        /* Get drawing lock */
+        TRACE_WAIT("drawLock", lockThreadLock(&engine->renderThreadData.drawLock));
+
+        /* Draw to screen */
+        if (atomicLoad(&engine->renderThreadData.showOverlay)){
+            TRACE_SCOPE("overlay"){
+                drawFrameOverlay(engine, *engine->renderThreadData.drawingBuffer);
+            }
+        }
+        TRACE_SCOPE("present"){
+            engine->backend->presentFrame(engine->backend, engine);
+        }
+        recordFrameInputs(engine, &engine->renderThreadData.drawingTimings);
+        updateFrameStats(engine, &engine->renderThreadData.drawingTimings);
 
         /* Release draw lock */
         unlockThreadLock(&engine->renderThreadData.drawLock);
 
         /* Sync with render thread */
-        enterThreadBarrier(&engine->renderThreadData.renderDrawBarrier);
+        TRACE_WAIT("renderDrawBarrier", enterThreadBarrier(&engine->renderThreadData.renderDrawBarrier));
 
         /* Sync with timer & render threads */
-        enterThreadBarrier(&engine->renderThreadData.timerBarrier);
+        TRACE_WAIT("timerBarrier", enterThreadBarrier(&engine->renderThreadData.timerBarrier));
 
         /* Get data lock */
-        lockThreadLock(&engine->renderThreadData.dataLock);
+        TRACE_WAIT("render dataLock", lockThreadLock(&engine->renderThreadData.dataLock));
 
         /* Check if we should exit */
         if (engine->renderThreadData.exit){
             /* Clean up */
 			unlockThreadLock(&engine->renderThreadData.dataLock);
+            engine->backend->stop(engine->backend, engine);
 
             /* Exit */
             exitThread(0);
@@ -604,6 +2892,28 @@ int drawingThreadFunction(void* data){
     }
 }
 
+// Runs jobs from a worker pool alongside the thread using the pool
+int workerPoolThreadFunction(void* data){
+    // This thread is passed a pointer to its pool
+    WorkerPool* pool = (WorkerPool*)data;
+
+    nameTraceThread("worker");
+
+    /* Keep looping until exitThread() is called */
+    while (true){
+        /* Wait for a job to be started */
+        TRACE_WAIT("startBarrier", enterThreadBarrier(&pool->startBarrier));
+
+        /* Check if we should exit */
+        if (pool->exit){
+            exitThread(0);
+        }
+
+        /* Run the job until there are no indexes left */
+        claimWorkerJobs(pool);
+    }
+}
+
 // Keeps track of time for the render loop
 int renderTimerThreadFunction(void* data){
     // This thread is passed a pointer to the engine
@@ -611,19 +2921,26 @@ int renderTimerThreadFunction(void* data){
 
     /* Wait for render ready signal */
     lockThreadLock(&engine->renderThreadData.dataLock);
-    waitForConditionSignal(&engine->renderThreadData.engineRenderReady, &engine->renderThreadData.dataLock);
+    // (renderReady is checked first, in case the signal was sent before this thread got here)
+    while (!engine->renderThreadData.renderReady){
+        waitForConditionSignal(&engine->renderThreadData.engineRenderReady, &engine->renderThreadData.dataLock);
+    }
     unlockThreadLock(&engine->renderThreadData.dataLock);
 
+    nameTraceThread("render timer");
+
     /* Keep looping until exitThread() is called */
     while (true){
-        /* Wait for MS_PER_FRAME */
-        sleepms(MS_PER_FRAME);
+        /* Wait for the frame period */
+        TRACE_SCOPE("sleep"){
+            sleepms(getFramePeriod(engine));
+        }
 
         /* Sync with render & draw threads */
-        enterThreadBarrier(&engine->renderThreadData.timerBarrier);
+        TRACE_WAIT("timerBarrier", enterThreadBarrier(&engine->renderThreadData.timerBarrier));
 
         /* Get data lock */
-        lockThreadLock(&engine->renderThreadData.dataLock);
+        TRACE_WAIT("render dataLock", lockThreadLock(&engine->renderThreadData.dataLock));
 
         /* Check if we should exit */
         if (engine->renderThreadData.exit){
@@ -18,6 +18,15 @@
 BaseMissionScreenState baseMissionScreenState;
 ThreadLock_t baseMissionScreenStateLock;
 
+/* Widget updates */
+static void updateModeWidgets(void* data);
+static void updatePowerWidgets(void* data);
+static void updateEngineChargeWidget(void* data);
+static void updateWeaponsChargeWidgets(void* data);
+static void updateShipHealthWidget(void* data);
+static void updateEnemyWeaponsWidget(void* data);
+static void updateAlienStrengthWidget(void* data);
+
 const char baseMissionInstructions[] = "-----Instructions-----\n"
     "While scouting this region of space you came across an alien base!\n\n"
 
@@ -48,6 +57,8 @@ const char baseMissionInstructions[] = "-----Instructions-----\n"
     "\nPress any key to exit this screen";
 
 void buildBaseMissionScreen(){
+    TRACE_BEGIN("buildBaseMissionScreen");
+
     /* Initialize lock and state */
     createLock(&baseMissionScreenStateLock);
     lockThreadLock(&baseMissionScreenStateLock);
@@ -64,6 +75,17 @@ void buildBaseMissionScreen(){
     // z is 20, to make sure it's above any other layer
     baseMissionScreenState.weaponFireOverlay = createPanel(gameState.engine->width, gameState.engine->height, 0, 0, 20);
     baseMissionScreenState.weaponFireOverlay->objectProperties.drawObject = drawWeaponFireOverlay;
+    setDrawFunctionName(drawWeaponFireOverlay, "WeaponFireOverlay");
+    // the overlay can be drawn by several render threads at once, so set up the cells it draws here
+    int colorBlack = getBestColor(0, 0, 0, gameState.engine);
+    int colorRed = getBestColor(255, 100, 100, gameState.engine);
+    int colorBlue = getBestColor(100, 100, 255, gameState.engine);
+    baseMissionScreenState.playerLaserChar.style = getCellStyle(COLOR_PAIR(getColorPair(colorRed, colorBlack, gameState.engine)));
+    baseMissionScreenState.playerLaserChar.glyph = getGlyph(L'#');
+    baseMissionScreenState.playerMissileChar.style = 0;
+    baseMissionScreenState.playerMissileChar.glyph = getGlyph(L'#');
+    baseMissionScreenState.enemyLaserChar.style = getCellStyle(COLOR_PAIR(getColorPair(colorBlue, colorBlack, gameState.engine)));
+    baseMissionScreenState.enemyLaserChar.glyph = getGlyph(L'#');
     gameState.baseMissionScreen->addObject(gameState.baseMissionScreen, (Object*)baseMissionScreenState.weaponFireOverlay);
 
     // regiter panel for events
@@ -168,6 +190,23 @@ void buildBaseMissionScreen(){
 
 
 
+    /* Bind widgets to the game state */
+    // the engine charge bar turns green when the engines can jump
+    int colorGreen = getBestColor(100, 255, 100, gameState.engine);
+    baseMissionScreenState.fullChargeAttr = COLOR_PAIR(getColorPair(colorGreen, colorBlack, gameState.engine));
+    ShipData* shipData = (ShipData*)baseMissionScreenState.shipObject->userData;
+    EnemyBaseData* enemyData = (EnemyBaseData*)baseMissionScreenState.enemyBase->userData;
+    baseMissionScreenState.modeVersion = 0;
+    createBindingList(&baseMissionScreenState.bindings);
+    bindWidget(&baseMissionScreenState.bindings, updateModeWidgets, NULL, 1, &baseMissionScreenState.modeVersion);
+    bindWidget(&baseMissionScreenState.bindings, updatePowerWidgets, shipData, 1, &shipData->powerVersion);
+    bindWidget(&baseMissionScreenState.bindings, updateEngineChargeWidget, shipData, 1, &shipData->engineChargeVersion);
+    bindWidget(&baseMissionScreenState.bindings, updateWeaponsChargeWidgets, shipData, 1, &shipData->weaponsChargeVersion);
+    bindWidget(&baseMissionScreenState.bindings, updateShipHealthWidget, NULL, 1, &gameState.shipHealthVersion);
+    bindWidget(&baseMissionScreenState.bindings, updateEnemyWeaponsWidget, enemyData, 1, &enemyData->weaponsChargeVersion);
+    bindWidget(&baseMissionScreenState.bindings, updateAlienStrengthWidget, NULL, 1, &gameState.alienStrengthVersion);
+    startBindingList(&baseMissionScreenState.bindings);
+
     /* Update listeners */
     gameState.baseMissionScreenListenerList = gameState.engine->mainPanel->listeners;
     gameState.engine->mainPanel->listeners = NULL;
@@ -175,13 +214,12 @@ void buildBaseMissionScreen(){
 
     /* Release lock */
     unlockThreadLock(&baseMissionScreenStateLock);
-}
 
-void refreshBaseMissionScreen(){
-    ShipData* shipData = (ShipData*)baseMissionScreenState.shipObject->userData;
-    EnemyBaseData* enemyData = (EnemyBaseData*)baseMissionScreenState.enemyBase->userData;
+    TRACE_END();
+}
 
-    /* Mode */
+/* Widget updates (bound to the game state in buildBaseMissionScreen()) */
+static void updateModeWidgets(void* data){
     switch (baseMissionScreenState.mode){
     case MODE_NORMAL:
         baseMissionScreenState.modeTextBox->objectProperties.show = false;
@@ -199,57 +237,54 @@ void refreshBaseMissionScreen(){
         updateTextBox(baseMissionScreenState.modeTextBox, " { Choose Room to Send Personnel } ", 0, true);
         break;
     }
+}
 
-    /* Power systems */
+static void updatePowerWidgets(void* data){
+    ShipData* shipData = (ShipData*)data;
     updateProgressBar(baseMissionScreenState.enginePowerProgressBar, (float)shipData->enginePower / 3.0f, 0);
     updateProgressBar(baseMissionScreenState.shieldPowerProgressBar, (float)shipData->shieldPower / 3.0f, 0);
     updateProgressBar(baseMissionScreenState.weaponsPowerProgressBar, (float)shipData->weaponsPower / 3.0f, 0);
     updateProgressBar(baseMissionScreenState.pilotPowerProgressBar, (float)shipData->pilotPower / 3.0f, 0);
     updateProgressBar(baseMissionScreenState.unusedPowerProgressBar, (float)(shipData->availablePower - shipData->usedPower) / (float)(shipData->totalPower), 0);
+}
 
-    /* Player stats */
-    int black = getBestColor(0, 0, 0, gameState.engine);
-    int green = getBestColor(100, 255, 100, gameState.engine);
-    int fullChargeAttr = COLOR_PAIR(getColorPair(green, black, gameState.engine));
-    // engine charge
-    updateProgressBar(baseMissionScreenState.engineChargeProgressBar, shipData->engineCharge, (shipData->engineCharge >= 1.0f)?fullChargeAttr:0);
-    // ship health
-    updateProgressBar(baseMissionScreenState.shipHelathProgressBar, gameState.shipHealth / 100.0f, 0);
-    // weapons
+static void updateEngineChargeWidget(void* data){
+    ShipData* shipData = (ShipData*)data;
+    updateProgressBar(baseMissionScreenState.engineChargeProgressBar, shipData->engineCharge, (shipData->engineCharge >= 1.0f)?baseMissionScreenState.fullChargeAttr:0);
+}
+
+static void updateWeaponsChargeWidgets(void* data){
+    ShipData* shipData = (ShipData*)data;
     updateProgressBar(baseMissionScreenState.weapon1ChargeProgressBar, shipData->weapons1Charge, 0);
     updateProgressBar(baseMissionScreenState.weapon2ChargeProgressBar, shipData->weapons2Charge, 0);
+}
 
-    /* Enemy stats */
-    // weapons
+static void updateShipHealthWidget(void* data){
+    updateProgressBar(baseMissionScreenState.shipHelathProgressBar, gameState.shipHealth / 100.0f, 0);
+}
+
+static void updateEnemyWeaponsWidget(void* data){
+    EnemyBaseData* enemyData = (EnemyBaseData*)data;
     updateProgressBar(baseMissionScreenState.enemyWeaponsProgressBar, enemyData->weaponsCharge, 0);
+}
+
+static void updateAlienStrengthWidget(void* data){
     // TEMP - alien strength
     updateProgressBar(baseMissionScreenState.alienStrengthProgressBar, gameState.alienStrenth / 100.0f, 0);
 }
 
 void drawWeaponFireOverlay(Object* overlay, CursesChar* buffer){
-    CursesChar* laserBolt = &buffer[(gameState.engine->stdscrHeight * baseMissionScreenState.playerLaserX) + baseMissionScreenState.playerLaserY];
-    CursesChar* missile = &buffer[(gameState.engine->stdscrHeight * baseMissionScreenState.playerMissileX) + baseMissionScreenState.playerMissileY];
-    CursesChar* enemyLaser = &buffer[(gameState.engine->stdscrHeight * baseMissionScreenState.enemyLaserX) + baseMissionScreenState.enemyLaserY];
-    
-    int colorBlack = getBestColor(0, 0, 0, gameState.engine);
-    int colorRed = getBestColor(255, 100, 100, gameState.engine);
-    int colorBlue = getBestColor(100, 100, 255, gameState.engine);
-    int playerColorPair = getColorPair(colorRed, colorBlack, gameState.engine);
-    int alienColorPair = getColorPair(colorBlue, colorBlack, gameState.engine);
-
+    // writecharToBuffer() keeps each shot inside the render tile being drawn
     if (baseMissionScreenState.playerLaserX + baseMissionScreenState.playerLaserY != 0){
-        laserBolt->attributes = COLOR_PAIR(playerColorPair);
-        laserBolt->character = L'#';
+        writecharToBuffer(buffer, baseMissionScreenState.playerLaserX, baseMissionScreenState.playerLaserY, &baseMissionScreenState.playerLaserChar);
     }
 
     if (baseMissionScreenState.playerMissileX + baseMissionScreenState.playerMissileY != 0){
-        missile->attributes = 0;
-        missile->character = L'#';
+        writecharToBuffer(buffer, baseMissionScreenState.playerMissileX, baseMissionScreenState.playerMissileY, &baseMissionScreenState.playerMissileChar);
     }
     
     if (baseMissionScreenState.enemyLaserX + baseMissionScreenState.enemyLaserY != 0){
-        enemyLaser->attributes = COLOR_PAIR(alienColorPair);
-        enemyLaser->character = L'#';
+        writecharToBuffer(buffer, baseMissionScreenState.enemyLaserX, baseMissionScreenState.enemyLaserY, &baseMissionScreenState.enemyLaserChar);
     }
 }
 
@@ -291,18 +326,20 @@ void updateBaseMissionScreen(Mission* mission){
     // This is called upon entering a mission, so we can update any objectives here
     // scout sector objective: +10% to fleet strength upon entering system
     gameState.fleetStrength += 10;
-
-    // remake screen
-    refreshBaseMissionScreen();
+    markChanged(&gameState.fleetStrengthVersion);
+
+    // everything was reset, so update every widget
+    markChanged(&baseMissionScreenState.modeVersion);
+    markChanged(&shipData->powerVersion);
+    markChanged(&shipData->engineChargeVersion);
+    markChanged(&shipData->weaponsChargeVersion);
+    markChanged(&enemyData->weaponsChargeVersion);
 }
 
 void baseMissionScreenHandleEvents(Object* overviewScreen, Event* event){
     // data for the player's ship
     ShipData* shipData = (ShipData*)baseMissionScreenState.shipObject->userData;
 
-    // used to signal the screen should be redrawn after processing events
-    bool redraw = false;
-
     /* If the event is a keyboard event, check if it's a valid action */
     if (event->eventType.values.keyboardEvent){
         // used when both the shifted and non-shifted cases run the same code, but the state needs to be known 
@@ -331,8 +368,8 @@ void baseMissionScreenHandleEvents(Object* overviewScreen, Event* event){
                     }
                 }
 
-                // screen needs to be redrawn to update power distribution indicators 
-                redraw = true;
+                // update power distribution indicators
+                markChanged(&shipData->powerVersion);
                 break;
             
             // Shields
@@ -354,8 +391,8 @@ void baseMissionScreenHandleEvents(Object* overviewScreen, Event* event){
                     }
                 }
 
-                // screen needs to be redrawn to update power distribution indicators 
-                redraw = true;
+                // update power distribution indicators
+                markChanged(&shipData->powerVersion);
                 break;
             
             // Weapons
@@ -377,8 +414,8 @@ void baseMissionScreenHandleEvents(Object* overviewScreen, Event* event){
                     }
                 }
 
-                // screen needs to be redrawn to update power distribution indicators 
-                redraw = true;
+                // update power distribution indicators
+                markChanged(&shipData->powerVersion);
                 break;
 
             // Pilot
@@ -400,17 +437,17 @@ void baseMissionScreenHandleEvents(Object* overviewScreen, Event* event){
                     }
                 }
 
-                // screen needs to be redrawn to update power distribution indicators 
-                redraw = true;
+                // update power distribution indicators
+                markChanged(&shipData->powerVersion);
                 break;
 
             // Pause
             case ' ':
             case 27:
                 baseMissionScreenState.mode = MODE_PAUSED;
+                markChanged(&baseMissionScreenState.modeVersion);
                 // change event listener
                 gameState.baseMissionScreen->objectProperties.handleEvent = baseMissionScreenHandleEventsPaused;
-                redraw = true;
                 break;
 
             case KEY_ENTER:
@@ -452,6 +489,13 @@ void baseMissionScreenHandleEvents(Object* overviewScreen, Event* event){
     }
     /* if the event is a timer event, update values that change with time */
     else if (event->eventType.values.timerEvent){
+        // charges shown by widgets before this update, so they're only marked changed if they move
+        EnemyBaseData* enemyData = (EnemyBaseData*)baseMissionScreenState.enemyBase->userData;
+        float lastEngineCharge = shipData->engineCharge;
+        float lastWeapons1Charge = shipData->weapons1Charge;
+        float lastWeapons2Charge = shipData->weapons2Charge;
+        float lastEnemyWeaponsCharge = enemyData->weaponsCharge;
+
         /* Calculate how much charge to add to engines */
         // more power in the engines causes faster charging,
         // as does more power to the pilot
@@ -589,6 +633,7 @@ void baseMissionScreenHandleEvents(Object* overviewScreen, Event* event){
                     
                     // deal damage
                     gameState.alienStrenth -= 1;
+                    markChanged(&gameState.alienStrengthVersion);
                 }
                 break;
             };
@@ -631,6 +676,7 @@ void baseMissionScreenHandleEvents(Object* overviewScreen, Event* event){
                     
                     // deal damage
                     gameState.alienStrenth -= 2;
+                    markChanged(&gameState.alienStrengthVersion);
                 }
                 break;
             };
@@ -705,6 +751,7 @@ void baseMissionScreenHandleEvents(Object* overviewScreen, Event* event){
 
                     // deal damage
                     gameState.shipHealth -= damage;
+                    markChanged(&gameState.shipHealthVersion);
 
                     // if health is at 0, end game
                     if (gameState.shipHealth <= 0){
@@ -726,12 +773,16 @@ void baseMissionScreenHandleEvents(Object* overviewScreen, Event* event){
             ((EnemyBaseData*)baseMissionScreenState.enemyBase->userData)->weaponsCharge = 0.0f;
         }
 
-        redraw = true;
-    }
-
-    // refresh the screen if data has changed
-    if (redraw){
-        refreshBaseMissionScreen();
+        /* Update widgets for the charges that changed */
+        if (shipData->engineCharge != lastEngineCharge){
+            markChanged(&shipData->engineChargeVersion);
+        }
+        if (shipData->weapons1Charge != lastWeapons1Charge || shipData->weapons2Charge != lastWeapons2Charge){
+            markChanged(&shipData->weaponsChargeVersion);
+        }
+        if (enemyData->weaponsCharge != lastEnemyWeaponsCharge){
+            markChanged(&enemyData->weaponsChargeVersion);
+        }
     }
 }
 
@@ -745,18 +796,17 @@ void baseMissionScreenHandleEventsPaused(Object* screen, Event* event){
             // show instructions
             case 'I':
             case 'i':
-                // show info object, switch event handler, refresh screen
+                // show info object, switch event handler
                 baseMissionScreenState.infoScreen->objectProperties.show = true;
                 gameState.baseMissionScreen->objectProperties.handleEvent = baseMissionScreenHandleEventsInfoScreen;
-                refreshBaseMissionScreen();
                 break;
 
             case ' ':
             case 27:
                 // unpause game
                 baseMissionScreenState.mode = MODE_NORMAL;
+                markChanged(&baseMissionScreenState.modeVersion);
                 gameState.baseMissionScreen->objectProperties.handleEvent = baseMissionScreenHandleEvents;
-                refreshBaseMissionScreen();
                 break;
         }
     }
@@ -770,7 +820,7 @@ void baseMissionScreenHandleEventsInfoScreen(Object* screen, Event* event){
         // on any keyboard event hide the info window and go to pause state
         baseMissionScreenState.infoScreen->objectProperties.show = false;
         baseMissionScreenState.mode = MODE_PAUSED;
+        markChanged(&baseMissionScreenState.modeVersion);
         gameState.baseMissionScreen->objectProperties.handleEvent = baseMissionScreenHandleEventsPaused;
-        refreshBaseMissionScreen();
     }
 }
@@ -24,6 +24,8 @@ char critSuccessText[] = "-----GAME OVER - You Won-----\n"
 
 /* Main functions */
 void buildGameOverScreen(){
+    TRACE_BEGIN("buildGameOverScreen");
+
     /* Initialize lock and state */
     createLock(&gameOverScreenStateLock);
     lockThreadLock(&gameOverScreenStateLock);
@@ -49,6 +51,8 @@ void buildGameOverScreen(){
 
     /* Release lock */
     unlockThreadLock(&gameOverScreenStateLock);
+
+    TRACE_END();
 }
 
 void updateGameOverScreen(GameResult result){
@@ -16,7 +16,15 @@
 OverviewScreenState overviewScreenState;
 ThreadLock_t overviewScreenStateLock;
 
+/* Status bar binding updates */
+static void updateShipHealthWidget(void* data);
+static void updateFleetStrengthWidget(void* data);
+static void updateAlienStrengthWidget(void* data);
+static void updateCreditsWidget(void* data);
+
 void buildOverviewScreen(){
+    TRACE_BEGIN("buildOverviewScreen");
+
     /* Initialize lock and state */
     createLock(&overviewScreenStateLock);
     lockThreadLock(&overviewScreenStateLock);
@@ -59,17 +67,26 @@ void buildOverviewScreen(){
     overviewScreenState.creditsTextBox = createTextBox("", 0, false, 6, 1, statsX + 44, statsY, 2, gameState.engine);
     gameState.overviewScreen->addObject(gameState.overviewScreen, (Object*)overviewScreenState.creditsTextBox);
 
+    // the stats are only redrawn on frames where they change
+    createBindingList(&overviewScreenState.bindings);
+    bindWidget(&overviewScreenState.bindings, updateShipHealthWidget, NULL, 1, &gameState.shipHealthVersion);
+    bindWidget(&overviewScreenState.bindings, updateFleetStrengthWidget, NULL, 1, &gameState.fleetStrengthVersion);
+    bindWidget(&overviewScreenState.bindings, updateAlienStrengthWidget, NULL, 1, &gameState.alienStrengthVersion);
+    bindWidget(&overviewScreenState.bindings, updateCreditsWidget, NULL, 1, &gameState.creditsVersion);
+    startBindingList(&overviewScreenState.bindings);
+
     /* Initialize locationMarkers array */
     for (int i = 0; i < 9; i++){
         overviewScreenState.locationMarkers[i] = NULL;
+        overviewScreenState.locationMarkerAnimated[i] = false;
         // will automatically be updated if marker is NULL, so set to false for now
         overviewScreenState.locationStatusChanged[i] = false;
     }
 
     /* Get location marker textures */
     overviewScreenState.locationUnknownTexture = getXPFile("./assets/Location_Unknown.xp");
-    overviewScreenState.locationCurrentFrames[0] = getXPFile("./assets/Location_Current1.xp");
-    overviewScreenState.locationCurrentFrames[1] = getXPFile("./assets/Location_Current2.xp");
+    XPFile* locationCurrentFrames[2] = {getXPFile("./assets/Location_Current1.xp"), getXPFile("./assets/Location_Current2.xp")};
+    overviewScreenState.locationCurrentTexture = createAXPSpriteTexture(locationCurrentFrames, 2, gameState.engine);
     overviewScreenState.locationCompletedTexture = getXPFile("./assets/Location_Completed.xp");
     overviewScreenState.locationSkippedTexture = getXPFile("./assets/Location_Skipped.xp");
 
@@ -130,20 +147,13 @@ void buildOverviewScreen(){
 
     /* unlock overview state mutex */
     unlockThreadLock(&overviewScreenStateLock);
+
+    TRACE_END();
 }
 
 void updateOverviewScreen(){
     lockThreadLock(&overviewScreenStateLock);
 
-    /* Update stats */
-    updateProgressBar(overviewScreenState.shipHealthProgressBar, gameState.shipHealth / 100.0f, 0);
-    updateProgressBar(overviewScreenState.fleetStrengthProgressBar, gameState.fleetStrength / 100.0f, 0);
-    updateProgressBar(overviewScreenState.alienStrengthProgressBar, gameState.alienStrenth / 100.0f, 0);
-
-    char creditsText[6]; // tmp buffer for output of snprintf to format the credits with leading 0s
-    snprintf(creditsText, 6, "%05d", gameState.credits);
-    updateTextBox(overviewScreenState.creditsTextBox, creditsText, 0, false);
-
     /* Update location markers */
     // Get height and y location for each marker (same for all of them)
     int markerHeight = overviewScreenState.locationUnknownTexture->layers[0].height;
@@ -154,6 +164,7 @@ void updateOverviewScreen(){
 
     for (int i = 0; i < 9; i++){
         GameObject* currentMarker = overviewScreenState.locationMarkers[i];
+        bool currentMarkerAnimated = overviewScreenState.locationMarkerAnimated[i];
         bool updateMarker = overviewScreenState.locationStatusChanged[i];
 
         /* if the gameobject for this marker is null, we need to update */
@@ -163,12 +174,13 @@ void updateOverviewScreen(){
 
         /* if the marker needs to be updated, create a new sprite for it */
         if (updateMarker){
+            overviewScreenState.locationMarkerAnimated[i] = (gameState.locations[i] == LOCATION_CURRENT);
             switch (gameState.locations[i]){
             case LOCATION_UNKNOWN:
                 overviewScreenState.locationMarkers[i] = createXPSprite(overviewScreenState.locationUnknownTexture, markerX, markerY, 3, gameState.engine);
                 break;
             case LOCATION_CURRENT:
-                overviewScreenState.locationMarkers[i] = createAXPSprite(overviewScreenState.locationCurrentFrames, 2, 500, markerX, markerY, 3, gameState.engine);
+                overviewScreenState.locationMarkers[i] = createAXPSpriteFromTexture(overviewScreenState.locationCurrentTexture, 500, markerX, markerY, 3);
                 break;
             case LOCATION_COMPLETED:
                 overviewScreenState.locationMarkers[i] = createXPSprite(overviewScreenState.locationCompletedTexture, markerX, markerY, 3, gameState.engine);
@@ -184,7 +196,11 @@ void updateOverviewScreen(){
             /* If the old marker wasn't null, remove it from the screen and delete it */
             if (currentMarker != NULL){
                 gameState.overviewScreen->removeObject(gameState.overviewScreen, (Object*)currentMarker);
-                destroyXPSprite(currentMarker);
+                if (currentMarkerAnimated){
+                    destroyAXPSprite(currentMarker);
+                } else {
+                    destroyXPSprite(currentMarker);
+                }
             }
             
             /* add the new marker to the screen */
@@ -261,6 +277,7 @@ void missionSelected(int index){
         break;
     case MISSION_STATION:
         gameState.credits += 10;
+        markChanged(&gameState.creditsVersion);
         break;
     case MISSION_STORE:
         break;
@@ -277,8 +294,7 @@ void missionSelected(int index){
     overviewScreenState.locationStatusChanged[gameState.currentSector] = true;
 
     /* Reset selection menu index, since it will be reused for the next sector */
-    ((SelectionWindowData*)overviewScreenState.missionSelectionMenu->userData)->currentSelection = 0;
-    drawSelectionWindowBuffer(overviewScreenState.missionSelectionMenu);
+    setSelectionWindowSelection(overviewScreenState.missionSelectionMenu, 0);
 
     /* Update overview screen */
     updateOverviewScreen();
@@ -324,9 +340,27 @@ void sectorSkipped(){
     overviewScreenState.locationStatusChanged[gameState.currentSector] = true;
     
     /* Reset selection menu index, since it will be reused for the next sector */
-    ((SelectionWindowData*)overviewScreenState.missionSelectionMenu->userData)->currentSelection = 0;
-    drawSelectionWindowBuffer(overviewScreenState.missionSelectionMenu);
+    setSelectionWindowSelection(overviewScreenState.missionSelectionMenu, 0);
 
     /* Update overview screen */
     updateOverviewScreen();
 }
+
+/* Status bar binding updates */
+static void updateShipHealthWidget(void* data){
+    updateProgressBar(overviewScreenState.shipHealthProgressBar, gameState.shipHealth / 100.0f, 0);
+}
+
+static void updateFleetStrengthWidget(void* data){
+    updateProgressBar(overviewScreenState.fleetStrengthProgressBar, gameState.fleetStrength / 100.0f, 0);
+}
+
+static void updateAlienStrengthWidget(void* data){
+    updateProgressBar(overviewScreenState.alienStrengthProgressBar, gameState.alienStrenth / 100.0f, 0);
+}
+
+static void updateCreditsWidget(void* data){
+    char creditsText[6]; // tmp buffer for output of snprintf to format the credits with leading 0s
+    snprintf(creditsText, 6, "%05d", gameState.credits);
+    updateTextBox(overviewScreenState.creditsTextBox, creditsText, 0, false);
+}
@@ -11,6 +11,8 @@ StationMissionScreenState stationMissionScreenState;
 ThreadLock_t stationMissionScreenStateLock;
 
 void buildStationMissionScreen(){
+    TRACE_BEGIN("buildStationMissionScreen");
+
     /* Initialize lock and state */
     createLock(&stationMissionScreenStateLock);
     lockThreadLock(&stationMissionScreenStateLock);
@@ -26,6 +28,8 @@ void buildStationMissionScreen(){
     
     /* Release lock */
     unlockThreadLock(&stationMissionScreenStateLock);
+
+    TRACE_END();
 }
 
 void updateStationMissionScreen(){
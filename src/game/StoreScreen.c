@@ -11,6 +11,8 @@ StoreScreenState storeScreenState;
 ThreadLock_t storeScreenStateLock;
 
 void buildStoreScreen(){
+    TRACE_BEGIN("buildStoreScreen");
+
     /* Initialize lock and state */
     createLock(&storeScreenStateLock);
     lockThreadLock(&storeScreenStateLock);
@@ -26,6 +28,8 @@ void buildStoreScreen(){
 
     /* Release lock */
     unlockThreadLock(&storeScreenStateLock);
+
+    TRACE_END();
 }
 
 void updateStoreScreen(){
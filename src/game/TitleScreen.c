@@ -20,6 +20,8 @@ const char* hardDescription = "Hard: For masochistic players who want to suffer\
 const char* demoDescription = "Demo: Easy difficulty with some modifications to make game faster for demos";
 
 void buildTitleScreen(){
+    TRACE_BEGIN("buildTitleScreen");
+
     /* Remove listeners and reset new listener pointer */
     gameState.engine->mainPanel->listeners = NULL;
     gameState.engine->mainPanel->nextListener = &gameState.engine->mainPanel->listeners;
@@ -80,6 +82,8 @@ void buildTitleScreen(){
     /* Remove listeners and reset new listener pointer */
     gameState.engine->mainPanel->listeners = NULL;
     gameState.engine->mainPanel->nextListener = &gameState.engine->mainPanel->listeners;
+
+    TRACE_END();
 }
 
 void updateTitleScreen(){
@@ -87,15 +91,15 @@ void updateTitleScreen(){
 }
 
 Panel* infoPanel = NULL;
-Panel* borderPanel = NULL;
+GameObject* infoPanelFrame = NULL;
 void infoPanelHandleEvents(Object* self, Event* event){
     if (event->eventType.values.keyboardEvent){
         if (*(char*)event->eventData == 'b'){
             // hide info window
             infoPanel->objectProperties.show = false;
-            borderPanel->objectProperties.show = false;
+            infoPanelFrame->objectProperties.show = false;
             gameState.engine->mainPanel->removeObject(gameState.engine->mainPanel, (Object*)infoPanel);
-            gameState.engine->mainPanel->removeObject(gameState.engine->mainPanel, (Object*)borderPanel);
+            gameState.engine->mainPanel->removeObject(gameState.engine->mainPanel, (Object*)infoPanelFrame);
 
             // change active window back to main window
             gameState.engine->activePanel = gameState.engine->mainPanel;
@@ -108,22 +112,21 @@ void clearInfoPanel(){
         int width = 100;
         int height = 50;
         // center the panel
-        int xpos = (COLS - width) / 2;
-        int ypos = (LINES - height) / 2;
+        int xpos = (gameState.engine->width - width) / 2;
+        int ypos = (gameState.engine->height - height) / 2;
         
-        // create a panel for the border
-        borderPanel = createPanel(width + 2, height + 2, xpos - 1, ypos - 1, 10);
-        // draw border
+        // create a border around the panel
+        infoPanelFrame = createFrame(BORDER_SINGLE, width + 2, height + 2, xpos - 1, ypos - 1, 10);
 
         // Create content panel
         infoPanel = createPanel(width, height, xpos, ypos, 10);
         infoPanel->objectProperties.handleEvent = infoPanelHandleEvents;
     }
    
-    borderPanel->objectProperties.show = true;
+    infoPanelFrame->objectProperties.show = true;
     infoPanel->objectProperties.show = true;
     gameState.engine->mainPanel->addObject(gameState.engine->mainPanel, (Object*)infoPanel);
-    gameState.engine->mainPanel->addObject(gameState.engine->mainPanel, (Object*)borderPanel);
+    gameState.engine->mainPanel->addObject(gameState.engine->mainPanel, (Object*)infoPanelFrame);
     // capture events from engine
     gameState.engine->activePanel = infoPanel;
 }
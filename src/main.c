@@ -28,37 +28,32 @@ int main(int argc, char* argv[]){
     /* Set locale for proper ncurses use */
     setlocale(LC_CTYPE, "");
 
-    /* Initialize engine */
-    // Run in a 256x72 window (~16x9 with chars that are twice as tall as they are wide)
-    Engine* engine = initializeEngine(256, 72);
-    
-    /* Write some debug output to stdscr, and a pause for debugging before starting the game */
-    wprintw(engine->stdscr, "DEBUG INFO:\n");
-    wprintw(engine->stdscr, "Term supports %d colors\n", COLORS);
-    wprintw(engine->stdscr, "Term supports %d color pairs\n", COLOR_PAIRS);
-    wprintw(engine->stdscr, "Term can change color: %s\n", (can_change_color())?"true":"false");
-    wprintw(engine->stdscr, "Terminal Size: %dx%d\n", COLS, LINES);
-
-    init_pair(1, COLOR_BLUE, COLOR_BLACK);
-    attron(COLOR_PAIR(1));
-    wprintw(engine->stdscr, "Testing Color - blue with black background...\n");
-    attroff(COLOR_PAIR(1));
-    
-    printw("Press any key to start...\n");
-    wgetch(engine->stdscr); // block on debug stuff until key is pressed
-
-    wclear(engine->stdscr);
-
-    /* Send engine ready for rendering signal to start rendering */
-    lockThreadLock(&engine->renderThreadData.dataLock);
-    broadcastConditionSignal(&engine->renderThreadData.engineRenderReady);
-    unlockThreadLock(&engine->renderThreadData.dataLock);
-
-    /* Run the game */
+    /* Read args */
     // if the program is run with --skipintro, skip the intro sequence (speeds up debugging the actual game)
     // if the program is run with --unlockfps, set MS_PER_FRAME to 0, which makes the game render at it's maximum possible fps
+    // if the program is run with --renderthreads=N, rasterize each frame with N threads (read when rendering starts, so before the signal below)
+    // if the program is run with --outputthreads=N, skip curses and encode each frame for the terminal with N threads (same as above)
+    // if the program is run with --headless, render into memory instead of the terminal (no input, and frames are drawn as fast as possible)
+    //  --dumpframes=FILE and --checksums=FILE write every frame, or its checksum, to a file (only with --headless)
+    //  --frames=N exits after N frames have been rendered
+    // if the program is run with --overlay, start with the frame overlay shown (F2 shows and hides it)
+    // if the program is run with --trace=FILE, record what every thread is doing and write it to FILE as a Chrome trace on exit
+    //  (sending SIGUSR1 writes what has been recorded so far, and SIGINT/SIGTERM exit cleanly so the trace is written)
+    // if the program is run with --drawprofile=FILE, time every object's draw, and write the scene tree with what each node cost to FILE
+    //  whenever a frame goes over budget (plus the totals for each type of object on exit)
+    //  --drawbudget=MS sets the budget (the frame period by default)
+    // if the program is run with --metrics=PATH, serve the engine's counters on a Unix domain socket at PATH (see metrics.h)
     bool skipIntro = false;
     bool unlockFPS = false;
+    bool headless = false;
+    const char* framePath = NULL;
+    const char* checksumPath = NULL;
+    unsigned int frameLimit = 0;
+    bool showOverlay = false;
+    const char* tracePath = NULL;
+    const char* drawProfilePath = NULL;
+    int drawBudget = -1;
+    const char* metricsPath = NULL;
 
     for (int i = 1; i < argc; i++){
         // loop through args
@@ -66,13 +61,82 @@ int main(int argc, char* argv[]){
             skipIntro = true;
         } else if ((strncmp(argv[i], "--unlockfps", 11) == 0)){
             unlockFPS = true;
+        } else if ((strncmp(argv[i], "--renderthreads=", 16) == 0)){
+            RENDER_THREADS = atoi(argv[i] + 16);
+        } else if ((strncmp(argv[i], "--outputthreads=", 16) == 0)){
+            OUTPUT_THREADS = atoi(argv[i] + 16);
+        } else if ((strncmp(argv[i], "--headless", 10) == 0)){
+            headless = true;
+        } else if ((strncmp(argv[i], "--dumpframes=", 13) == 0)){
+            framePath = argv[i] + 13;
+        } else if ((strncmp(argv[i], "--checksums=", 12) == 0)){
+            checksumPath = argv[i] + 12;
+        } else if ((strncmp(argv[i], "--frames=", 9) == 0)){
+            frameLimit = atoi(argv[i] + 9);
+        } else if ((strncmp(argv[i], "--overlay", 9) == 0)){
+            showOverlay = true;
+        } else if ((strncmp(argv[i], "--trace=", 8) == 0)){
+            tracePath = argv[i] + 8;
+        } else if ((strncmp(argv[i], "--drawprofile=", 14) == 0)){
+            drawProfilePath = argv[i] + 14;
+        } else if ((strncmp(argv[i], "--drawbudget=", 13) == 0)){
+            drawBudget = atoi(argv[i] + 13);
+        } else if ((strncmp(argv[i], "--metrics=", 10) == 0)){
+            metricsPath = argv[i] + 10;
         }
     }
 
+    /* Start tracing before any threads are started */
+    if (tracePath != NULL){
+        startTrace(tracePath, 0);
+        nameTraceThread("main");
+    }
+
+    /* Initialize engine */
+    // Run in a 256x72 window (~16x9 with chars that are twice as tall as they are wide)
+    Engine* engine = initializeEngineWithBackend(256, 72, (headless)? createHeadlessBackend(framePath, checksumPath, 0) : createTerminalBackend());
+
+    /* Write some debug output to stdscr, and a pause for debugging before starting the game */
+    // (there's nobody to press a key when running headless)
+    if (!headless){
+        wprintw(engine->stdscr, "DEBUG INFO:\n");
+        wprintw(engine->stdscr, "Term supports %d colors\n", COLORS);
+        wprintw(engine->stdscr, "Term supports %d color pairs\n", COLOR_PAIRS);
+        wprintw(engine->stdscr, "Term can change color: %s\n", (can_change_color())?"true":"false");
+        wprintw(engine->stdscr, "Terminal Size: %dx%d\n", COLS, LINES);
+
+        init_pair(1, COLOR_BLUE, COLOR_BLACK);
+        attron(COLOR_PAIR(1));
+        wprintw(engine->stdscr, "Testing Color - blue with black background...\n");
+        attroff(COLOR_PAIR(1));
+        
+        printw("Press any key to start...\n");
+        wgetch(engine->stdscr); // block on debug stuff until key is pressed
+
+        wclear(engine->stdscr);
+    }
+
     // set MS_PER_FRAME if unlockFPS is true
     if (unlockFPS){
         MS_PER_FRAME = 0;
     }
+    setFrameOverlay(engine, showOverlay);
+    bool drawProfileStarted = false;
+    if (drawProfilePath != NULL){
+        drawProfileStarted = startDrawProfile(engine, drawProfilePath, (drawBudget >= 0)? drawBudget : getFramePeriod(engine));
+    }
+    bool metricsStarted = false;
+    if (metricsPath != NULL){
+        metricsStarted = startMetricsServer(engine, metricsPath);
+    }
+
+    /* Send engine ready for rendering signal to start rendering */
+    lockThreadLock(&engine->renderThreadData.dataLock);
+    engine->renderThreadData.renderReady = true;
+    broadcastConditionSignal(&engine->renderThreadData.engineRenderReady);
+    unlockThreadLock(&engine->renderThreadData.dataLock);
+
+    /* Run the game */
 
     // call to startGame in AlcubierreGame.c
     startGame(engine, skipIntro);
@@ -84,11 +148,31 @@ int main(int argc, char* argv[]){
     int input;
     int lastUpdate = getTimems();
     while ((input = getch_safe(engine)) != KEY_F(1)){
+        // input latency is measured from here (see Event.timestamp)
+        uint64_t inputTime = getTimeus();
         lockThreadLock(&gameStateLock);
         if (gameState.exit){
             break;
         }
         unlockThreadLock(&gameStateLock);
+        // stop if asked to by a signal (only caught while tracing)
+        if (pollTraceSignals()){
+            break;
+        }
+        // stop once enough frames have been rendered, if there's a limit
+        if (frameLimit > 0){
+            lockThreadLock(&engine->renderThreadData.dataLock);
+            bool framesDone = engine->renderThreadData.framesRendered >= frameLimit;
+            unlockThreadLock(&engine->renderThreadData.dataLock);
+            if (framesDone){
+                break;
+            }
+        }
+        // F2 shows and hides the frame overlay, the game never sees it
+        if (input == KEY_F(2)){
+            toggleFrameOverlay(engine);
+            input = ERR;
+        }
         // create keyboard input event if key pressed
         if (input != ERR){
             // the memory is managed by the event thread after we send the event, so no need to free the event here
@@ -96,6 +180,7 @@ int main(int argc, char* argv[]){
             keyEvent->eventType.mask = 0;
             keyEvent->eventType.values.keyboardEvent = TRUE;
             keyEvent->eventData = (void*)(uintptr_t)input; // we don't want to send a pointer in this case - just the char data which will fit into the size of a void pointer
+            keyEvent->timestamp = inputTime;
 			keyEvent->next = NULL;
 
             // send events
@@ -108,6 +193,7 @@ int main(int argc, char* argv[]){
         timeEvent->eventType.values.timerEvent = true;
         timeEvent->eventData = (void*)(uintptr_t)(getTimems() - lastUpdate); // data for time event is the time in ms since the last timer event
         lastUpdate = getTimems();
+        timeEvent->timestamp = 0;
         timeEvent->next = NULL;
 
         // send event
@@ -118,14 +204,29 @@ int main(int argc, char* argv[]){
     }
 
     /* Exit after cleaning up the engine */
+    stopMetricsServer();
     destroyEngine(engine);
+    if (metricsPath != NULL && !metricsStarted){
+        printf("Unable to serve metrics on %s\n", metricsPath);
+    }
+    if (drawProfilePath != NULL && !drawProfileStarted){
+        printf("Unable to open %s for the draw profile\n", drawProfilePath);
+    }
+
+    /* Write the trace once every thread has stopped */
+    if (tracePath != NULL){
+        if (!writeTrace()){
+            printf("Unable to write trace to %s\n", tracePath);
+        }
+        stopTrace();
+    }
 
     return 0;
 }
 
 // Thread safe getch()
 int getch_safe(Engine* engine){
-    lockThreadLock(&engine->renderThreadData.drawLock);
+    TRACE_WAIT("drawLock", lockThreadLock(&engine->renderThreadData.drawLock));
     int ch = wgetch(engine->stdscr);
     unlockThreadLock(&engine->renderThreadData.drawLock);
     return ch;
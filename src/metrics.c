@@ -0,0 +1,200 @@
+/*
+ * Created by Sean Bowers
+ * CS 2060 section 3, Spring 2018
+ * University of Colorado at Colorado Springs
+ *
+ * Licensed under the MIT License (see LICENSE.txt)
+ */
+/* Implementation of the metrics server (metrics.h) */
+
+#include <metrics.h>
+#include <engine.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#ifdef __UNIX__
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#endif
+
+// how often the server checks if it should stop while waiting for connections (ms)
+#define METRICS_POLL_MS 100
+
+static const char* eventMetricTypeNames[EVENT_METRIC_TYPES] = {"keyboard", "gamemsg", "timer", "other"};
+
+static Engine* metricsEngine = NULL;
+static char* metricsPath = NULL;
+static Thread_t metricsThread;
+static volatile int metricsExit = 0;
+
+#ifdef __UNIX__
+static int metricsSocket = -1;
+
+/* Snapshot text */
+typedef struct MetricsText_s{
+    char* text;
+    size_t length;
+    size_t capacity;
+} MetricsText;
+
+static void appendMetricsText(MetricsText* metrics, const char* format, ...){
+    va_list args;
+    while (true){
+        va_start(args, format);
+        int length = vsnprintf(&metrics->text[metrics->length], metrics->capacity - metrics->length, format, args);
+        va_end(args);
+        if (length < 0){
+            return;
+        }
+        if (metrics->length + length < metrics->capacity){
+            metrics->length += length;
+            return;
+        }
+        metrics->capacity *= 2;
+        metrics->text = (char*) realloc(metrics->text, metrics->capacity);
+    }
+}
+
+// Writes a metric's HELP and TYPE lines, and its value if it doesn't have labels
+#define METRIC(type, name, help, format, value)\
+    appendMetricsText(metrics, "# HELP alcubierre_" name " " help "\n# TYPE alcubierre_" name " " type "\n"\
+            "alcubierre_" name " " format "\n", value)
+
+static void formatMetrics(Engine* engine, MetricsText* metrics){
+    struct RenderThreadData_s* renderData = &engine->renderThreadData;
+    struct EventThreadData_s* eventData = &engine->eventThreadData;
+
+    /* Frames */
+    // framesRendered is only written by the render thread, so it can be read without its lock
+    METRIC("counter", "frames_rendered_total", "Frames rendered into a buffer.", "%u", (unsigned int)atomicLoad(&renderData->framesRendered));
+    METRIC("counter", "frames_emitted_total", "Frames presented by the backend.", "%u", (unsigned int)atomicLoad(&renderData->framesEmitted));
+    METRIC("counter", "frames_dropped_total", "Frame deadlines that passed without a new frame.", "%u", (unsigned int)atomicLoad(&renderData->framesDropped));
+
+    /* Events */
+    METRIC("gauge", "event_queue_depth", "Events queued but not dispatched yet.", "%d", atomicLoad(&eventData->queueDepth));
+    appendMetricsText(metrics, "# HELP alcubierre_events_dispatched_total Events dispatched to the active panel.\n"
+            "# TYPE alcubierre_events_dispatched_total counter\n");
+    for (int type = 0; type < EVENT_METRIC_TYPES; type++){
+        appendMetricsText(metrics, "alcubierre_events_dispatched_total{type=\"%s\"} %u\n", eventMetricTypeNames[type],
+                (unsigned int)atomicLoad(&eventData->eventsDispatched[type]));
+    }
+
+    /* Terminal */
+    METRIC("gauge", "color_pairs_used", "Color pairs created by getColorPair().", "%d", atomicLoad(&nextColorPair) - 1);
+    METRIC("gauge", "color_pairs_max", "Color pairs the terminal supports (COLOR_PAIRS).", "%d", COLOR_PAIRS);
+    METRIC("counter", "tty_bytes_total", "Bytes of frames written to the terminal (only when printing directly).", "%lld",
+            (long long)atomicLoad64(&renderData->ttyBytes));
+
+    /* Memory */
+    METRIC("gauge", "buffer_memory_bytes", "Bytes held by frame, panel, draw list, and output buffers.", "%lld",
+            (long long)atomicLoad64(&bufferMemory));
+}
+#undef METRIC
+
+/* Server */
+// Sends the whole snapshot, giving up if the client goes away
+static void sendMetrics(int client, MetricsText* metrics){
+    size_t sent = 0;
+    while (sent < metrics->length){
+        ssize_t written = send(client, &metrics->text[sent], metrics->length - sent, MSG_NOSIGNAL);
+        if (written <= 0){
+            return;
+        }
+        sent += written;
+    }
+}
+
+static int metricsThreadFunction(void* data){
+    nameTraceThread("metrics");
+    MetricsText metrics;
+    metrics.capacity = 2048;
+    metrics.text = (char*) malloc(metrics.capacity);
+
+    while (!atomicLoad(&metricsExit)){
+        // wait for a connection, checking every so often if the server should stop
+        struct pollfd waiting = {metricsSocket, POLLIN, 0};
+        if (poll(&waiting, 1, METRICS_POLL_MS) <= 0){
+            continue;
+        }
+        int client = accept(metricsSocket, NULL, NULL);
+        if (client < 0){
+            continue;
+        }
+
+        TRACE_SCOPE("serve metrics"){
+            metrics.length = 0;
+            metrics.text[0] = '\0';
+            formatMetrics(metricsEngine, &metrics);
+            sendMetrics(client, &metrics);
+        }
+        close(client);
+    }
+
+    free(metrics.text);
+    return 0;
+}
+#endif
+
+bool startMetricsServer(Engine* engine, const char* path){
+    #ifdef __UNIX__
+    if (metricsEngine != NULL){
+        return false;
+    }
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)){
+        return false;
+    }
+    strcpy(address.sun_path, path);
+
+    // replace a socket left behind by an earlier run (but nothing else)
+    struct stat existing;
+    if (stat(path, &existing) == 0 && S_ISSOCK(existing.st_mode)){
+        unlink(path);
+    }
+
+    metricsSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (metricsSocket < 0){
+        return false;
+    }
+    if (bind(metricsSocket, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(metricsSocket, 4) != 0){
+        close(metricsSocket);
+        metricsSocket = -1;
+        return false;
+    }
+
+    metricsPath = (char*) malloc(strlen(path) + 1);
+    strcpy(metricsPath, path);
+    metricsEngine = engine;
+    atomicStore(&metricsExit, 0);
+    createThread(&metricsThread, (ThreadProcess_t)metricsThreadFunction, NULL);
+    return true;
+    #elif __WIN32__
+    return false;
+    #endif
+}
+
+void stopMetricsServer(){
+    if (metricsEngine == NULL){
+        return;
+    }
+
+    #ifdef __UNIX__
+    atomicStore(&metricsExit, 1);
+    joinThread(&metricsThread);
+    close(metricsSocket);
+    metricsSocket = -1;
+    unlink(metricsPath);
+    #endif
+
+    free(metricsPath);
+    metricsPath = NULL;
+    metricsEngine = NULL;
+}
@@ -14,15 +14,131 @@
 /* GameObject functions */
 void AXPSpriteDraw(Object* self, CursesChar* buffer);
 
+/* Timer callback */
+static uint64_t advanceAXPSprite(void* spriteData, uint64_t frameTime);
+
 /* Implementation of sprites.h functions */
 
-GameObject* createAXPSprite(XPFile** textures, int numFrames, int msPerFrame, int xpos, int ypos, int zorder, Engine* engine){
+AXPSpriteTextureData* createAXPSpriteTexture(XPFile** textures, int numFrames, Engine* engine){
+    AXPSpriteTextureData* texture = (AXPSpriteTextureData*) malloc(sizeof(AXPSpriteTextureData));
+    texture->width = textures[0]->layers[0].width;
+    texture->height = textures[0]->layers[0].height;
+    texture->numFrames = numFrames;
+    texture->refCount = 1;
+
+    /* Create each frame */
+    int width = texture->width;
+    int height = texture->height;
+    int numCells = width * height;
+    texture->frames = (AXPSpriteFrame*) malloc(sizeof(AXPSpriteFrame) * numFrames);
+    // every frame is rasterized here first, then kept as a keyframe or turned into a list of changes
+    CursesChar* frameBuffer = (CursesChar*) malloc(sizeof(CursesChar) * numCells);
+    AXPSpriteFrame* keyframe = NULL;
+    
+    for (int layer = 0; layer < numFrames; layer++){
+        AXPSpriteFrame* frame = &texture->frames[layer];
+
+        /* Initialize frame buffer with transparent cells */
+        for (int y = 0; y < height; y++){
+            for (int x = 0; x < width; x++){
+                CursesChar* backgroundChar = &frameBuffer[(width * y) + x];
+                backgroundChar->style = 0;
+                // transparent cell denoted by NBSP unicode character
+                backgroundChar->glyph = GLYPH_TRANSPARENT;
+            }
+        }
+        /* Draw texture to buffer */
+        drawLayerToBuffer(&textures[layer]->layers[0], frameBuffer, true, engine);
+
+        /* Count the cells that differ from the last keyframe */
+        // a change list entry is twice the size of a cell, so changes must be under a quarter of the cells to save memory
+        int maxChanges = numCells / 4;
+        int numChanges = 0;
+        if (keyframe != NULL){
+            for (int cell = 0; cell < numCells && numChanges <= maxChanges; cell++){
+                CursesChar* keyCell = &keyframe->cells[cell];
+                CursesChar* newCell = &frameBuffer[cell];
+                if (keyCell->glyph != newCell->glyph || keyCell->style != newCell->style){
+                    // the keyframe is drawn under the changes, so a cell can't turn transparent (or opaque) in a change list
+                    if ((keyCell->glyph == GLYPH_TRANSPARENT) != (newCell->glyph == GLYPH_TRANSPARENT)){
+                        numChanges = maxChanges + 1;
+                        break;
+                    }
+                    numChanges++;
+                }
+            }
+        }
+
+        if (keyframe != NULL && numChanges <= maxChanges){
+            /* Store as changes from the keyframe */
+            frame->isKeyframe = false;
+            frame->cells = keyframe->cells;
+            frame->opaqueRows = keyframe->opaqueRows;
+            frame->numChanges = numChanges;
+            frame->changes = (AXPSpriteCellChange*) malloc(sizeof(AXPSpriteCellChange) * numChanges);
+            int change = 0;
+            for (int cell = 0; cell < numCells; cell++){
+                if (keyframe->cells[cell].glyph != frameBuffer[cell].glyph || keyframe->cells[cell].style != frameBuffer[cell].style){
+                    frame->changes[change].index = cell;
+                    frame->changes[change].cell = frameBuffer[cell];
+                    change++;
+                }
+            }
+        } else {
+            /* Store as a new keyframe */
+            frame->isKeyframe = true;
+            frame->cells = frameBuffer;
+            frame->changes = NULL;
+            frame->numChanges = 0;
+            frame->opaqueRows = (bool*) malloc(sizeof(bool) * texture->height);
+            for (int y = 0; y < height; y++){
+                frame->opaqueRows[y] = true;
+                for (int x = 0; x < width; x++){
+                    if (frameBuffer[(width * y) + x].glyph == GLYPH_TRANSPARENT){
+                        frame->opaqueRows[y] = false;
+                        break;
+                    }
+                }
+            }
+            keyframe = frame;
+
+            // the keyframe keeps this buffer, so the next frame needs a new one
+            frameBuffer = (CursesChar*) malloc(sizeof(CursesChar) * numCells);
+        }
+    }
+    free(frameBuffer);
+
+    return texture;
+}
+
+void releaseAXPSpriteTexture(AXPSpriteTextureData* texture){
+    // the last owner to let go frees it
+    if (atomicDecrement(&texture->refCount) > 0){
+        return;
+    }
+
+    /* Free frames */
+    for (int frame = 0; frame < texture->numFrames; frame++){
+        AXPSpriteFrame* currentFrame = &texture->frames[frame];
+        if (currentFrame->isKeyframe){
+            free(currentFrame->cells);
+            free(currentFrame->opaqueRows);
+        }
+        free(currentFrame->changes);
+    }
+    free(texture->frames);
+
+    /* Free texture data */
+    free(texture);
+}
+
+GameObject* createAXPSpriteFromTexture(AXPSpriteTextureData* texture, int msPerFrame, int xpos, int ypos, int zorder){
     /* Create Game Object */
     GameObject* newObject = (GameObject*)malloc(sizeof(GameObject));
-    newObject->timeCreated = getTimems();
     
     /* Base Object Properties */
     newObject->objectProperties.drawObject = AXPSpriteDraw;
+    setDrawFunctionName(AXPSpriteDraw, "AXPSprite");
     newObject->objectProperties.handleEvent = NULL;
     newObject->objectProperties.next = NULL;
     newObject->objectProperties.previous = NULL;
@@ -30,6 +146,7 @@ GameObject* createAXPSprite(XPFile** textures, int numFrames, int msPerFrame, in
     newObject->objectProperties.x = xpos;
     newObject->objectProperties.y = ypos;
     newObject->objectProperties.z = zorder;
+    newObject->objectProperties.parent = NULL;
     newObject->objectProperties.show = true;
 
     /* Game Object properties */
@@ -37,48 +154,39 @@ GameObject* createAXPSprite(XPFile** textures, int numFrames, int msPerFrame, in
     AXPSpriteData* data = (AXPSpriteData*) malloc(sizeof(AXPSpriteData));
     newObject->userData = data;
 
-    // copy the array of xpfile pointers
-    data->textures = (XPFile**) malloc(sizeof(XPFile*) * numFrames);
-    memcpy(data->textures, textures, sizeof(XPFile*)*numFrames);
-    data->textureData = (AXPSpriteTextureData*) malloc(sizeof(AXPSpriteTextureData));
-    data->textureData->width = textures[0]->layers[0].width;
-    data->textureData->height = textures[0]->layers[0].height;
+    // share the texture
+    atomicIncrement(&texture->refCount);
+    data->textureData = texture;
+
+    /* Playback state */
     data->currentFrame = 0;
-    data->lastFrameTime = getTimems();
-    data->numFrames = numFrames;
+    data->lastFrameTime = newObject->timeCreated;
     data->msPerFrame = msPerFrame;
+    data->numFrames = texture->numFrames;
+    // the timer is started the first time the sprite is drawn
+    data->timer.scheduled = false;
+    data->lastDrawnFrame = -1;
+    data->stopped = 1;
 
-    /* Create buffer for each frame */
-    data->textureData->frames = (CursesChar**) malloc(sizeof(CursesChar*) * numFrames);
-    
-    for (int layer = 0; layer < numFrames; layer++){
-        /* Allocate buffer */
-        data->textureData->frames[layer] = (CursesChar*) malloc(sizeof(CursesChar) * textures[0]->layers[0].width * textures[0]->layers[0].height);
-
-        /* Initialize texture buffer with transparent cells */
-        for (int x = 0; x < data->textureData->width; x++){
-            for (int y = 0; y < data->textureData->height; y++){
-                CursesChar* backgroundChar = &data->textureData->frames[layer][(data->textureData->height * x) + y];
-                backgroundChar->attributes = 0;
-                // transparent cell denoted by NBSP unicode character
-                backgroundChar->character = L'\u00A0';
-            }
-        }
-        /* Draw texture to buffer */
-        drawLayerToBuffer(&textures[layer]->layers[0], data->textureData->frames[layer], true, engine);
-    }
+    return newObject;
+}
 
+GameObject* createAXPSprite(XPFile** textures, int numFrames, int msPerFrame, int xpos, int ypos, int zorder, Engine* engine){
+    AXPSpriteTextureData* texture = createAXPSpriteTexture(textures, numFrames, engine);
+    GameObject* newObject = createAXPSpriteFromTexture(texture, msPerFrame, xpos, ypos, zorder);
+    // the sprite holds the only reference now
+    releaseAXPSpriteTexture(texture);
     return newObject;
 }
 
 void destroyAXPSprite(GameObject* sprite){
     AXPSpriteData* data = (AXPSpriteData*)sprite->userData;
 
-    /* Free frames */
-    free(data->textureData->frames);
+    /* Stop the timer */
+    cancelTimer(&data->timer);
 
-    /* Free texture data */
-    free(data->textureData);
+    /* Release the shared texture */
+    releaseAXPSpriteTexture(data->textureData);
 
     /* Free sprite data struct */
     free(data);
@@ -88,28 +196,68 @@ void destroyAXPSprite(GameObject* sprite){
 }
 
 /* Implementation of custom functions */
+static uint64_t advanceAXPSprite(void* spriteData, uint64_t frameTime){
+    AXPSpriteData* data = (AXPSpriteData*)spriteData;
+
+    /* Move forward however many frames have passed */
+    if (frameTime >= data->lastFrameTime + data->msPerFrame){
+        uint64_t framesPassed = (frameTime - data->lastFrameTime) / data->msPerFrame;
+        data->currentFrame = (data->currentFrame + framesPassed) % data->numFrames;
+        data->lastFrameTime += framesPassed * data->msPerFrame;
+    }
+
+    /* Stop if the sprite wasn't drawn in the last frame */
+    // the next time it's drawn starts the timer again
+    if (atomicLoad(&data->lastDrawnFrame) < getFrameNumber() - 1){
+        atomicStore(&data->stopped, 1);
+        return 0;
+    }
+
+    return data->lastFrameTime + data->msPerFrame;
+}
+
 void AXPSpriteDraw(Object* self, CursesChar* buffer){
     AXPSpriteData* data = (AXPSpriteData*)((GameObject*)self)->userData;
+    int width = data->textureData->width;
 
-    // If enough time has passed, move on to the next frame
-    if ((getTimems() - data->lastFrameTime) >= (data->msPerFrame)){
-        data->currentFrame++;
-        data->lastFrameTime = getTimems();
-        if (data->currentFrame >= data->numFrames){
-            data->currentFrame = 0;
-        }
+    // currentFrame is only changed by the timer, which runs before the frame is rasterized
+    AXPSpriteFrame* frame = &data->textureData->frames[data->currentFrame];
+
+    // only draw the part of the frame inside the current render tile
+    int startX, startY, endX, endY;
+    if (!clipToRenderTile(buffer, width, data->textureData->height, &startX, &startY, &endX, &endY)){
+        return;
+    }
+
+    /* Keep the timer running while the sprite is on screen */
+    atomicStore(&data->lastDrawnFrame, getFrameNumber());
+    // only one tile restarts the timer
+    if (atomicLoad(&data->stopped) && atomicExchange(&data->stopped, 0)){
+        scheduleTimer(&data->timer, getFrameTimems(), advanceAXPSprite, data);
     }
 
-    // Draw frame[currentFrame]
-    /* Add chars from frame to buffer */
-    CursesChar* frame = data->textureData->frames[data->currentFrame];
-    for (int x = 0; x < data->textureData->width; x++){
-        for (int y = 0; y < data->textureData->height; y++){
-            CursesChar* textureChar = &frame[(data->textureData->height * x) + y];
-            // if char is not NBSP (\u00A0), draw it. (NBSP is transparent character for our case)
-            if (textureChar->character != L'\u00A0'){
-                writecharToBuffer(buffer, x, y, textureChar);
+    /* Draw the keyframe */
+    for (int y = startY; y < endY; y++){
+        CursesChar* sourceRow = &frame->cells[width * y];
+        CursesChar* bufferRow = &buffer[BUFFER_STRIDE * y];
+        if (frame->opaqueRows[y]){
+            // nothing to skip, so copy the whole row at once
+            memcpy(&bufferRow[startX], &sourceRow[startX], sizeof(CursesChar) * (endX - startX));
+        } else {
+            for (int x = startX; x < endX; x++){
+                if (sourceRow[x].glyph != GLYPH_TRANSPARENT){
+                    bufferRow[x] = sourceRow[x];
+                }
             }
         }
     }
+
+    /* Draw the cells that change in this frame */
+    for (int change = 0; change < frame->numChanges; change++){
+        int x = frame->changes[change].index % width;
+        int y = frame->changes[change].index / width;
+        if (x >= startX && x < endX && y >= startY && y < endY){
+            buffer[(BUFFER_STRIDE * y) + x] = frame->changes[change].cell;
+        }
+    }
 }
@@ -25,6 +25,7 @@ GameObject* createEnemyBase(int x, int y, int z, Engine* engine){
     newObject->objectProperties.y = y;
     newObject->objectProperties.z = z;
     newObject->objectProperties.drawObject = defaultEnemyBaseDraw;
+    setDrawFunctionName(defaultEnemyBaseDraw, "EnemyBase");
     newObject->objectProperties.handleEvent = NULL;
 
     /* User data */
@@ -33,6 +34,7 @@ GameObject* createEnemyBase(int x, int y, int z, Engine* engine){
 
     // default game data
     data->weaponsCharge = 0;
+    data->weaponsChargeVersion = 0;
 
     // load texture
     data->texture = getXPFile("./assets/EnemyBase.xp");
@@ -107,13 +109,5 @@ void defaultEnemyBaseDraw(Object* self, CursesChar* buffer){
     EnemyBaseData* data = (EnemyBaseData*)((GameObject*)self)->userData;
 
     /* Draw buffer */
-    for (int x = 0; x < data->bufferWidth; x++){
-        for (int y = 0; y < data->bufferHeight; y++){
-            CursesChar* bufferChar = &data->buffer[(data->bufferHeight * x) + y];
-            // if char is not NBSP (\u00A0), draw it. (NBSP is transparent character for our case)
-            if (bufferChar->character != L'\u00A0'){
-                writecharToBuffer(buffer, x, y, bufferChar);
-            }
-        }
-    }
+    drawBufferToBuffer(buffer, data->buffer, data->bufferWidth, data->bufferHeight);
 }
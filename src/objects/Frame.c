@@ -0,0 +1,52 @@
+/*
+ * Created by Sean Bowers
+ * CS 2060 section 3, Spring 2018
+ * University of Colorado at Colorado Springs
+ *
+ * Licensed under the MIT License (see LICENSE.txt)
+ */
+#include <engine.h>
+#include <objects/ui.h>
+#include <stdlib.h>
+
+void defaultDrawFrame(Object* self, CursesChar* buffer);
+
+GameObject* createFrame(BorderStyle style, int width, int height, int x, int y, int z){
+    GameObject* newObject = (GameObject*) malloc(sizeof(GameObject));
+
+    /* Initialize object properties */
+    newObject->objectProperties.next = NULL;
+    newObject->objectProperties.parent = NULL;
+    newObject->objectProperties.previous = NULL;
+    newObject->objectProperties.show = true;
+    newObject->objectProperties.type = OBJECT_GAMEOBJECT;
+    newObject->objectProperties.x = x;
+    newObject->objectProperties.y = y;
+    newObject->objectProperties.z = z;
+    newObject->objectProperties.drawObject = defaultDrawFrame;
+    setDrawFunctionName(defaultDrawFrame, "Frame");
+    newObject->objectProperties.handleEvent = NULL;
+
+    /* Initialize user data */
+    // the border is shared with every other border of the same style and width
+    FrameData* data = (FrameData*) malloc(sizeof(FrameData));
+    newObject->userData = data;
+    data->border = getBorderTemplate(style, width);
+    data->width = width;
+    data->height = height;
+
+    return newObject;
+}
+
+void destroyFrame(GameObject* frame){
+    // the border template isn't owned by the frame
+    free(frame->userData);
+
+    free(frame);
+}
+
+void defaultDrawFrame(Object* self, CursesChar* buffer){
+    FrameData* data = (FrameData*)((GameObject*)self)->userData;
+
+    drawBorderToBuffer(buffer, data->border, data->height);
+}
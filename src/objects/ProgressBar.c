@@ -9,6 +9,7 @@
 #include <objects/ui.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
 void defaultDrawProgressBar(Object* self, CursesChar* buffer);
 
@@ -28,6 +29,7 @@ GameObject* createProgressBar(const char* label, float percentage, attr_t attrib
     newObject->objectProperties.y = y;
     newObject->objectProperties.z = z;
     newObject->objectProperties.drawObject = defaultDrawProgressBar;
+    setDrawFunctionName(defaultDrawProgressBar, "ProgressBar");
     newObject->objectProperties.handleEvent = NULL;
 
     /* Initialize user data */
@@ -46,7 +48,17 @@ GameObject* createProgressBar(const char* label, float percentage, attr_t attrib
     // initialize buffer
     data->buffer = (CursesChar*) malloc(sizeof(CursesChar)*data->bufferWidth*data->bufferHeight);
 
+    // draw the label and brackets, which never change
+    // remove the label from the rest of the width, minus 2 for the left and right brackets contianing the progress bar
+    data->barX = labelWidth + 1;
+    data->barWidth = (data->bufferWidth - labelWidth) - 2;
+    bufferPutString(data->buffer, data->bufferWidth, data->bufferWidth, data->bufferHeight, 0, 0, 0, data->label);
+    bufferPutString(data->buffer, data->bufferWidth, data->bufferWidth, data->bufferHeight, labelWidth, 0, 0, "[");
+    bufferPutString(data->buffer, data->bufferWidth, data->bufferWidth, data->bufferHeight, data->bufferWidth - 1, 0, 0, "]");
+
     // draw progress bar to buffer (done in update function)
+    data->filledWidth = -1;
+    data->attributes = attributes;
     updateProgressBar(newObject, percentage, attributes);
     
     return newObject;
@@ -60,40 +72,54 @@ void destroyProgressBar(GameObject* progressBar){
 }
 
 // updates the percentage for the progress bar
-void updateProgressBar(GameObject* progressBar, float newPercentage, attr_t attributes){
+DirtyRect updateProgressBar(GameObject* progressBar, float newPercentage, attr_t attributes){
     ProgressBarData* data = (ProgressBarData*)progressBar->userData;
-
     data->percentage = newPercentage;
-    // remove the label from the rest of the width, minus 2 for the left and right brackets contianing the progress bar
-    int progressBarWidth = (data->bufferWidth - strlen(data->label)) - 2;
-
-    bufferPrintf(data->buffer, data->bufferWidth, data->bufferHeight, data->bufferHeight, 0, 0, 0, "%s[", data->label);
-    int progressBarStartX = strlen(data->label) + 1;
-    for (int i = 0; i < progressBarWidth; i++){
-        if (((float)i / (float)progressBarWidth) < (data->percentage)){
-            // if i/width is inside of the percentage, draw a full character
-            bufferPrintf(data->buffer, data->bufferWidth, data->bufferHeight, data->bufferHeight, progressBarStartX+i, 0, attributes, "%c", '#');
-        } else {
-            // if i/width is outside of the percentage, draw a blank character
-            bufferPrintf(data->buffer, data->bufferWidth, data->bufferHeight, data->bufferHeight, progressBarStartX+i, 0, attributes, "%c", ' ');
-        }
+
+    // a cell is filled if it's inside of the percentage (i/width < percentage)
+    int filledWidth = (int)ceilf(newPercentage * (float)data->barWidth);
+    if (filledWidth < 0){
+        filledWidth = 0;
+    } else if (filledWidth > data->barWidth){
+        filledWidth = data->barWidth;
+    }
+
+    DirtyRect dirty = {data->barX, 0, 0, 1};
+    if (filledWidth == data->filledWidth && attributes == data->attributes){
+        // nothing visible changed
+        return dirty;
     }
 
-    // print closing bracket
-    data->buffer[data->bufferWidth - 1].character = ']';
+    /* Work out which cells changed */
+    int start = 0;
+    int end = data->barWidth;
+    if (data->filledWidth >= 0 && attributes == data->attributes){
+        // only the cells between the old and new fill level
+        start = (filledWidth < data->filledWidth) ? filledWidth : data->filledWidth;
+        end = (filledWidth > data->filledWidth) ? filledWidth : data->filledWidth;
+    }
+
+    /* Redraw them */
+    int fillEnd = (end < filledWidth) ? end : filledWidth;
+    int blankStart = (start > filledWidth) ? start : filledWidth;
+    if (fillEnd > start){
+        bufferFill(data->buffer, data->bufferWidth, data->barX + start, 0, fillEnd - start, 1, attributes, L'#');
+    }
+    if (end > blankStart){
+        bufferFill(data->buffer, data->bufferWidth, data->barX + blankStart, 0, end - blankStart, 1, attributes, L' ');
+    }
+
+    data->filledWidth = filledWidth;
+    data->attributes = attributes;
+
+    dirty.x += start;
+    dirty.width = end - start;
+    return dirty;
 }
 
 void defaultDrawProgressBar(Object* self, CursesChar* buffer){
     ProgressBarData* data = (ProgressBarData*)((GameObject*)self)->userData;
 
     /* Draw buffer */
-    for (int x = 0; x < data->bufferWidth; x++){
-        for (int y = 0; y < data->bufferHeight; y++){
-            CursesChar* bufferChar = &data->buffer[(data->bufferHeight * x) + y];
-            // if char is not NBSP (\u00A0), draw it. (NBSP is transparent character for our case)
-            if (bufferChar->character != L'\u00A0'){
-                writecharToBuffer(buffer, x, y, bufferChar);
-            }
-        }
-    }
+    drawBufferToBuffer(buffer, data->buffer, data->bufferWidth, data->bufferHeight);
 }
@@ -25,6 +25,7 @@ GameObject* createPlayerShip(int x, int y, int z, Engine* engine){
     newObject->objectProperties.y = y;
     newObject->objectProperties.z = z;
     newObject->objectProperties.drawObject = defaultPlayerShipDraw;
+    setDrawFunctionName(defaultPlayerShipDraw, "PlayerShip");
     newObject->objectProperties.handleEvent = NULL;
 
     /* User data */
@@ -33,6 +34,9 @@ GameObject* createPlayerShip(int x, int y, int z, Engine* engine){
 
     // default game data
     data->engineCharge = 0;
+    data->powerVersion = 0;
+    data->engineChargeVersion = 0;
+    data->weaponsChargeVersion = 0;
 
     // load ship texture
     data->texture = getXPFile("./assets/Alcubierre.xp");
@@ -107,13 +111,5 @@ void defaultPlayerShipDraw(Object* self, CursesChar* buffer){
     ShipData* data = (ShipData*)((GameObject*)self)->userData;
 
     /* Draw buffer */
-    for (int x = 0; x < data->bufferWidth; x++){
-        for (int y = 0; y < data->bufferHeight; y++){
-            CursesChar* bufferChar = &data->buffer[(data->bufferHeight * x) + y];
-            // if char is not NBSP (\u00A0), draw it. (NBSP is transparent character for our case)
-            if (bufferChar->character != L'\u00A0'){
-                writecharToBuffer(buffer, x, y, bufferChar);
-            }
-        }
-    }
+    drawBufferToBuffer(buffer, data->buffer, data->bufferWidth, data->bufferHeight);
 }
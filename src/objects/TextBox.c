@@ -12,6 +12,10 @@
 void defaultDrawTextBox(Object* self, CursesChar* buffer);
 void defaultTextBoxHandleEvent(Object* self, Event* event);
 
+/* Layout helpers */
+static void layoutTextBox(TextBoxData* data, const char* text, TextBoxLine* lines);
+static void drawTextBoxRow(TextBoxData* data, int row);
+
 GameObject* createTextBox(const char* text, attr_t attributes, bool bordered, int width, int height, int x, int y, int z, Engine* engine){
     GameObject* newObject = (GameObject*) malloc(sizeof(GameObject));
     TextBoxData* data = (TextBoxData*) malloc(sizeof(TextBoxData));
@@ -27,106 +31,185 @@ GameObject* createTextBox(const char* text, attr_t attributes, bool bordered, in
     newObject->objectProperties.y = y;
     newObject->objectProperties.z = z;
     newObject->objectProperties.drawObject = defaultDrawTextBox;
+    setDrawFunctionName(defaultDrawTextBox, "TextBox");
     newObject->objectProperties.handleEvent = defaultTextBoxHandleEvent;
 
     /* Text box data */
     data->attributes = attributes;
-    data->text = (char*) malloc(sizeof(char) * (strlen(text) + 1));
-    strncpy(data->text, text, strlen(text) + 1);
+    // starts empty, the text is set by updateTextBox() below
+    data->textCapacity = strlen(text) + 1;
+    data->text = (char*) malloc(sizeof(char) * data->textCapacity);
+    data->text[0] = '\0';
     data->bordered = bordered;
+    data->width = width;
+    data->height = height;
     data->textWidth = width;
     data->textHeight = height;
 
-    /* Create buffer */
-    data->bufferWidth = width;
-    data->bufferHeight = height;
-    
     // if bordered more width & height will be reserved for the border, so decrease text width & height
+    // the border itself isn't in the buffer, so text updates never have to redraw it
+    data->border = NULL;
     if (bordered){
         data->textWidth -= 2;
         data->textHeight -= 2;
+        data->border = getBorderTemplate(BORDER_SINGLE, width);
     }
-    
-    data->buffer = (CursesChar*) malloc(sizeof(CursesChar) * data->bufferWidth * data->bufferHeight);
+
+    /* Create buffer */
+    data->buffer = (CursesChar*) malloc(sizeof(CursesChar) * data->textWidth * data->textHeight);
+
+    /* Create layout */
+    data->center = false;
+    data->textX = 0;
+    data->lines = (TextBoxLine*) malloc(sizeof(TextBoxLine) * data->textHeight);
+    data->newLines = (TextBoxLine*) malloc(sizeof(TextBoxLine) * data->textHeight);
+    layoutTextBox(data, data->text, data->lines);
 
     // draw to buffer
+    for (int row = 0; row < data->textHeight; row++){
+        drawTextBoxRow(data, row);
+    }
     updateTextBox(newObject, text, attributes, false);
 
     return newObject;
 }
 
-void updateTextBox(GameObject* textBox, const char* newText, attr_t attributes, bool center){
+void destroyTextBox(GameObject* textBox){
+    TextBoxData* data = (TextBoxData*)textBox->userData;
+    free(data->text);
+    free(data->buffer);
+    free(data->lines);
+    free(data->newLines);
+    free(data);
+    free(textBox);
+}
+
+DirtyRect updateTextBox(GameObject* textBox, const char* newText, attr_t attributes, bool center){
     TextBoxData* data = ((TextBoxData*)textBox->userData);
-    
+    DirtyRect dirty = {0, 0, data->width, 0};
+
+    /* Check if anything changed */
+    if (attributes == data->attributes && center == data->center && strcmp(newText, data->text) == 0){
+        return dirty;
+    }
+
+    /* Lay out the new text */
+    int newLength = strlen(newText);
+    int newTextX = 0;
+    if (center && newLength < data->textWidth){
+        newTextX = (data->textWidth - newLength) / 2.0f;
+    }
+    layoutTextBox(data, newText, data->newLines);
+
+    /* Find the rows that changed */
+    // if the attributes or position changed every line has to be redrawn
+    bool redrawAll = (attributes != data->attributes) || (newTextX != data->textX);
+    int firstRow = data->textHeight;
+    int lastRow = -1;
+    for (int row = 0; row < data->textHeight; row++){
+        TextBoxLine* oldLine = &data->lines[row];
+        TextBoxLine* newLine = &data->newLines[row];
+        if (redrawAll || oldLine->length != newLine->length || memcmp(&data->text[oldLine->start], &newText[newLine->start], newLine->length) != 0){
+            if (row < firstRow){
+                firstRow = row;
+            }
+            lastRow = row;
+        }
+    }
+
     /* Update data fields */
     data->attributes = attributes;
-    free(data->text);
-    data->text = (char*) malloc(sizeof(char) * (strlen(newText) + 1));
-    strncpy(data->text, newText, strlen(newText) + 1);
-
-    /* Redraw buffer */
-    // Fill buffer with either transparency if not bordered, or a border and spaces if bordered
-    for (int x = 0; x < data->bufferWidth; x++){
-        for (int y = 0; y < data->bufferHeight; y++){
-            CursesChar* charAt = &data->buffer[(x * data->bufferHeight) + y];
-
-            // set char
-            if (data->bordered){
-                charAt->attributes = 0;
-                if (x == 0 && y == 0){
-                    // top left
-                    charAt->character = L'┌';
-                } else if (x == 0 && y == (data->bufferHeight-1)){
-                    // bottom left
-                    charAt->character = L'└';
-                } else if (x == (data->bufferWidth-1) && y == 0){
-                    // top right
-                    charAt->character = L'┐';
-                } else if (x == (data->bufferWidth-1) && y == (data->bufferHeight-1)){
-                    // bottom right
-                    charAt->character = L'┘';
-                } else if (x == 0 || x == (data->bufferWidth-1)){
-                    // sides
-                    charAt->character = L'│';
-                } else if (y == 0 || y == (data->bufferHeight-1)){
-                    // top & bottom
-                    charAt->character = L'─';
-                } else {
-                    // inside
-                    charAt->character = L' ';
-                }
-            } else {
-                // set transparent
-                charAt->attributes = 0;
-                charAt->character = L'\u00A0';
-            }
+    data->center = center;
+    data->textX = newTextX;
+    if (newLength + 1 > data->textCapacity){
+        // only reallocate if the text doesn't fit
+        data->textCapacity = newLength + 1;
+        data->text = (char*) realloc(data->text, sizeof(char) * data->textCapacity);
+    }
+    memcpy(data->text, newText, newLength + 1);
+    TextBoxLine* tmp = data->lines;
+    data->lines = data->newLines;
+    data->newLines = tmp;
+
+    /* Redraw the changed rows */
+    for (int row = firstRow; row <= lastRow; row++){
+        drawTextBoxRow(data, row);
+    }
+
+    if (lastRow >= 0){
+        dirty.y = firstRow + ((data->bordered)? 1: 0);
+        dirty.height = (lastRow - firstRow) + 1;
+    }
+    return dirty;
+}
+
+// Splits text into the lines it's printed on (the same way bufferPrintf() wraps it)
+static void layoutTextBox(TextBoxData* data, const char* text, TextBoxLine* lines){
+    layoutText(text, data->textWidth, lines, data->textHeight);
+}
+
+int layoutText(const char* text, int width, TextBoxLine* lines, int maxLines){
+    if (lines != NULL){
+        for (int row = 0; row < maxLines; row++){
+            lines[row].start = 0;
+            lines[row].length = 0;
         }
     }
 
-    /* Print text to buffer */
-    int startX;
-    if (!center){
-        startX = (data->bordered)? 1: 0;
-    } else {
-        startX = (data->bufferWidth - strlen(data->text)) / 2.0f;
+    int row = 0;
+    int length = 0; // of the current line
+    for (int i = 0; text[i] && (row < maxLines); i++){
+        if (text[i] == '\n'){
+            // move to next line
+            row++;
+        } else {
+            // add char to this line, if it's full go to the next line
+            length++;
+            if (lines != NULL){
+                lines[row].length = length;
+            }
+            if (length < width){
+                continue;
+            }
+            row++;
+        }
+
+        // the next line starts after this char
+        length = 0;
+        if (lines != NULL && row < maxLines){
+            lines[row].start = i + 1;
+        }
     }
-    int startY = (data->bordered)? 1: 0;
-    bufferPrintf(data->buffer, data->textWidth, data->bufferHeight, data->textHeight, startX, startY, data->attributes, "%s", data->text);
 
+    // a line that was started but has nothing on it doesn't count
+    return (length > 0)? row + 1: row;
+}
+
+// Redraws one row of the buffer - the background and any text on it
+static void drawTextBoxRow(TextBoxData* data, int row){
+    // Fill row with either transparency if not bordered, or spaces if bordered
+    bufferFill(data->buffer, data->textWidth, 0, row, data->textWidth, 1, 0, (data->bordered)? L' ': L'\u00A0');
+
+    /* Print this row's line of text */
+    TextBoxLine* line = &data->lines[row];
+    uint16_t style = getCellStyle(data->attributes);
+    CursesChar* rowStart = &data->buffer[(row * data->textWidth) + data->textX];
+    int length = (line->length < data->textWidth - data->textX)? line->length: data->textWidth - data->textX;
+    for (int i = 0; i < length; i++){
+        rowStart[i].style = style;
+        rowStart[i].glyph = getGlyph((unsigned char)data->text[line->start + i]);
+    }
 }
 
 void defaultDrawTextBox(Object* self, CursesChar* buffer){
     TextBoxData* data = (TextBoxData*)((GameObject*)self)->userData;
 
-    /* Draw buffer */
-    for (int x = 0; x < data->bufferWidth; x++){
-        for (int y = 0; y < data->bufferHeight; y++){
-            CursesChar* bufferChar = &data->buffer[(data->bufferHeight * x) + y];
-            // if char is not NBSP (\u00A0), draw it. (NBSP is transparent character for our case)
-            if (bufferChar->character != L'\u00A0'){
-                writecharToBuffer(buffer, x, y, bufferChar);
-            }
-        }
+    /* Draw border, then the inside */
+    if (data->bordered){
+        drawBorderToBuffer(buffer, data->border, data->height);
+        drawBufferToBuffer(&buffer[BUFFER_STRIDE + 1], data->buffer, data->textWidth, data->textHeight);
+    } else {
+        drawBufferToBuffer(buffer, data->buffer, data->textWidth, data->textHeight);
     }
 }
 
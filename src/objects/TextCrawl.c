@@ -0,0 +1,109 @@
+/*
+ * Created by Sean Bowers
+ * CS 2060 section 3, Spring 2018
+ * University of Colorado at Colorado Springs
+ *
+ * Licensed under the MIT License (see LICENSE.txt)
+ */
+#include <engine.h>
+#include <objects/ui.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+void defaultDrawTextCrawl(Object* self, CursesChar* buffer);
+
+GameObject* createTextCrawl(const char* text, attr_t attributes, int width, int height, int x, int y, int z, Engine* engine){
+    GameObject* newObject = (GameObject*) malloc(sizeof(GameObject));
+
+    /* Initialize object properties */
+    newObject->objectProperties.next = NULL;
+    newObject->objectProperties.parent = NULL;
+    newObject->objectProperties.previous = NULL;
+    newObject->objectProperties.show = true;
+    newObject->objectProperties.type = OBJECT_GAMEOBJECT;
+    newObject->objectProperties.x = x;
+    newObject->objectProperties.y = y;
+    newObject->objectProperties.z = z;
+    newObject->objectProperties.drawObject = defaultDrawTextCrawl;
+    setDrawFunctionName(defaultDrawTextCrawl, "TextCrawl");
+    newObject->objectProperties.handleEvent = NULL;
+
+    /* Initialize user data */
+    TextCrawlData* data = (TextCrawlData*) malloc(sizeof(TextCrawlData));
+    newObject->userData = data;
+    data->engine = engine;
+    data->style = getCellStyle(attributes);
+    data->width = width;
+    data->height = height;
+    data->topRow = 0;
+    data->step = 0;
+
+    // copy the text, since the lines point into it
+    data->text = (char*) malloc(sizeof(char) * (strlen(text) + 1));
+    strcpy(data->text, text);
+
+    /* Lay out the text */
+    data->numLines = layoutText(data->text, width, NULL, INT_MAX);
+    data->lines = (TextBoxLine*) malloc(sizeof(TextBoxLine) * (data->numLines + 1));
+    layoutText(data->text, width, data->lines, data->numLines);
+
+    /* Start transparent */
+    // lines are blanked out as they crawl in, so whatever is behind the crawl shows until then
+    data->buffer = (CursesChar*) malloc(sizeof(CursesChar) * width * height);
+    bufferFill(data->buffer, width, 0, 0, width, height, 0, L'\u00A0');
+
+    return newObject;
+}
+
+void destroyTextCrawl(GameObject* textCrawl){
+    TextCrawlData* data = (TextCrawlData*)textCrawl->userData;
+
+    free(data->text);
+    free(data->lines);
+    free(data->buffer);
+
+    free(data);
+    free(textCrawl);
+}
+
+bool advanceTextCrawl(GameObject* textCrawl){
+    TextCrawlData* data = (TextCrawlData*)textCrawl->userData;
+
+    /* Scroll up */
+    // the top row falls off and is reused for the new bottom row
+    CursesChar* newRow = &data->buffer[data->width * data->topRow];
+    data->topRow = (data->topRow + 1) % data->height;
+
+    /* Draw the new line */
+    bufferFill(newRow, data->width, 0, 0, data->width, 1, 0, L' ');
+    bool hasText = (data->step < data->numLines);
+    if (hasText){
+        TextBoxLine* line = &data->lines[data->step];
+        for (int i = 0; i < line->length; i++){
+            newRow[i].style = data->style;
+            newRow[i].glyph = getGlyph((unsigned char)data->text[line->start + i]);
+        }
+    }
+    data->step++;
+
+    /* Let the output know the rows moved */
+    // only the lines that have crawled in moved, the rest of the crawl is still transparent
+    int x, y;
+    getAbsolutePosition((Object*)textCrawl, 0, 0, &x, &y);
+    int crawledRows = (data->step < data->height)? data->step: data->height;
+    scrollFrameArea(data->engine, x, y + (data->height - crawledRows), data->width, crawledRows, 1);
+
+    return hasText;
+}
+
+void defaultDrawTextCrawl(Object* self, CursesChar* buffer){
+    TextCrawlData* data = (TextCrawlData*)((GameObject*)self)->userData;
+
+    // the ring is drawn in two parts: from the top row to the end of the buffer, then the start of the buffer
+    int firstPartHeight = data->height - data->topRow;
+    drawBufferToBuffer(buffer, &data->buffer[data->width * data->topRow], data->width, firstPartHeight);
+    if (data->topRow > 0){
+        drawBufferToBuffer(&buffer[BUFFER_STRIDE * firstPartHeight], data->buffer, data->width, data->topRow);
+    }
+}
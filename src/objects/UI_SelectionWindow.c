@@ -17,17 +17,23 @@ void drawSelectionWindow(Object* self, CursesChar* buffer);
 void selectionWindowHandleEvents(Object* self, Event* event);
 
 /* Helper function for drawing the buffer */
-void drawSelectionWindowBuffer(GameObject* selectionWindow);
+static void drawSelectionWindowRow(SelectionWindowData* data, int option);
 
 /* ui.h implementation */
 
 GameObject* createSelectionWindow(char** list, char* keys, bool bordered, bool arrowSelection, pfn_SelectionCallback* callbacks, pfn_SelectionCallback selectionChangedCallback, bool registerForEvents, int numOptions, int minWidth, int xpos, int ypos, int z, Engine* engine){
+    // every option is visible
+    return createScrollingSelectionWindow(list, keys, bordered, arrowSelection, callbacks, selectionChangedCallback, registerForEvents, numOptions, numOptions, minWidth, xpos, ypos, z, engine);
+}
+
+GameObject* createScrollingSelectionWindow(char** list, char* keys, bool bordered, bool arrowSelection, pfn_SelectionCallback* callbacks, pfn_SelectionCallback selectionChangedCallback, bool registerForEvents, int numOptions, int visibleRows, int minWidth, int xpos, int ypos, int z, Engine* engine){
     /* Create new game object */
     GameObject* newObject = (GameObject*) malloc(sizeof(GameObject));
     newObject->timeCreated = getTimems();
 
     /* Initialize object properties */
     newObject->objectProperties.drawObject = drawSelectionWindow;
+    setDrawFunctionName(drawSelectionWindow, "SelectionWindow");
     newObject->objectProperties.handleEvent = selectionWindowHandleEvents;
     newObject->objectProperties.next = NULL;
     newObject->objectProperties.previous = NULL;
@@ -46,9 +52,12 @@ GameObject* createSelectionWindow(char** list, char* keys, bool bordered, bool a
     data->bordered = bordered;
     data->arrowSelection = arrowSelection;
     data->currentSelection = 0;
+    data->visibleRows = (visibleRows < numOptions) ? visibleRows : numOptions;
+    data->firstVisible = 0;
 
     /* Set width & height */
-    data->height = numOptions;
+    // the buffer only holds the visible rows
+    data->height = data->visibleRows;
     data->width = minWidth;
     for (int i = 0; i < numOptions; i++){
         if (strlen(list[i]) > data->width){
@@ -66,7 +75,15 @@ GameObject* createSelectionWindow(char** list, char* keys, bool bordered, bool a
         data->width += 2;
     }
 
-    
+    // the border isn't in the buffer, so it never has to be redrawn
+    data->bufferWidth = data->width;
+    data->bufferHeight = data->visibleRows;
+    data->border = NULL;
+    if (bordered){
+        data->bufferWidth -= 2;
+        data->border = getBorderTemplate(BORDER_SINGLE, data->width);
+    }
+
     // Since we're passed pointers that we don't control the memory of, we need to allocate new space on the heap and copy the data over
     data->list = (char**) malloc(sizeof(char*) * numOptions);
     memcpy(data->list, list, sizeof(char*) * numOptions);
@@ -76,19 +93,17 @@ GameObject* createSelectionWindow(char** list, char* keys, bool bordered, bool a
     memcpy(data->callbacks, callbacks, sizeof(pfn_SelectionCallback) * numOptions);
     data->selectionChangedCallback = selectionChangedCallback;
 
-    /* Set up buffer */
-    data->buffer = (CursesChar*) malloc(sizeof(CursesChar) * data->width * data->height);
-    
-    // fill buffer with default chars
-    for (int x = 0; x < data->width; x++){
-        for (int y = 0; y < data->height; y++){
-            CursesChar* currentChar = &data->buffer[(data->height * x) + y];
-            currentChar->attributes = 0;
-            // clear char array
-            // if bordered, fill with spaces, else fill with transparent NBSP char
-            currentChar->character = (bordered)?L' ':L'\u00A0';
-        }
+    /* Build hotkey table */
+    for (int key = 0; key < 256; key++){
+        data->hotkeys[key] = -1;
     }
+    // go backwards so the first option with a key gets it
+    for (int i = numOptions - 1; i >= 0; i--){
+        data->hotkeys[(unsigned char)keys[i]] = i;
+    }
+
+    /* Set up buffer */
+    data->buffer = (CursesChar*) malloc(sizeof(CursesChar) * data->bufferWidth * data->bufferHeight);
 
     /* draw buffer */
     drawSelectionWindowBuffer(newObject);
@@ -108,6 +123,7 @@ void destroySelectionWindow(GameObject* selectionWindow){
     SelectionWindowData* data = (SelectionWindowData*) selectionWindow->userData;
 
     // free memory allocated inside data
+    free(data->buffer);
     free(data->list);
     free(data->keys);
     free(data->callbacks);
@@ -120,90 +136,111 @@ void destroySelectionWindow(GameObject* selectionWindow){
 /* Draw buffer */
 void drawSelectionWindowBuffer(GameObject* selectionWindow){
     SelectionWindowData* data = (SelectionWindowData*)selectionWindow->userData;
-    /* Print border to buffer if needed */
-    if (data->bordered){
-        // print top and bottom
-        for (int x = 1; x < (data->width-1); x++){
-            CursesChar* topChar = &data->buffer[(x * data->height) + 0];
-            CursesChar* bottomChar = &data->buffer[(x * data->height) + data->height - 1];
-            topChar->character = bottomChar->character = L'─'; // set char to horizontal line
-        }
 
-        // print corners
-        CursesChar* topLeft = &data->buffer[(0 * data->height) + 0];
-        CursesChar* topRight = &data->buffer[((data->width-1) * data->height) + 0];
-        CursesChar* bottomLeft = &data->buffer[(0 * data->height) + (data->height-1)];
-        CursesChar* bottomRight = &data->buffer[((data->width-1) * data->height) + (data->height-1)];
+    for (int row = 0; row < data->visibleRows; row++){
+        drawSelectionWindowRow(data, data->firstVisible + row);
+    }
+}
 
-        topLeft->character = L'┌';
-        topRight->character = L'┐';
-        bottomLeft->character = L'└';
-        bottomRight->character = L'┘';
-    
-        // sides are printed with options
+void setSelectionWindowSelection(GameObject* selectionWindow, int selection){
+    SelectionWindowData* data = (SelectionWindowData*)selectionWindow->userData;
+    if (selection < 0 || selection >= data->numOptions || selection == data->currentSelection){
+        return;
     }
+    int previousSelection = data->currentSelection;
+    data->currentSelection = selection;
 
-    /* Print options to buffer */
-    for (int i = 0; i < data->numOptions; i++){
-        /* Get x,y position to print string at */
-        int x = 0;
-        int y = i;
-        if (data->bordered){
-            x += 1;
-            y += 1;
-        }
-        if (data->arrowSelection){
-            x += 1;
-        }
+    /* Scroll so the selection is visible */
+    int firstVisible = data->firstVisible;
+    if (selection < firstVisible){
+        firstVisible = selection;
+    } else if (selection >= firstVisible + data->visibleRows){
+        firstVisible = selection - data->visibleRows + 1;
+    }
 
-        /* Pre-option (border and/or selection arrows) */
-        if (data->bordered){
-            CursesChar* borderChar = &data->buffer[ (0 * data->height) + y];
-            borderChar->character = L'│';
-        }
-        if (data->arrowSelection){
-            CursesChar* arrowChar = &data->buffer[ (1 * data->height) + y];
-            if (i==data->currentSelection){
-                arrowChar->character = L'♦';
+    if (firstVisible != data->firstVisible){
+        int scroll = firstVisible - data->firstVisible;
+        int oldFirstVisible = data->firstVisible;
+        data->firstVisible = firstVisible;
+
+        if (abs(scroll) < data->visibleRows){
+            // options that stay visible are moved rather than redrawn, rows are contiguous in the buffer
+            int movedRows = data->visibleRows - abs(scroll);
+            CursesChar* top = data->buffer;
+            if (scroll > 0){
+                memmove(top, top + (data->bufferWidth * scroll), sizeof(CursesChar) * data->bufferWidth * movedRows);
             } else {
-                arrowChar->character = L' ';
+                memmove(top - (data->bufferWidth * scroll), top, sizeof(CursesChar) * data->bufferWidth * movedRows);
             }
-        }
 
-        /* Print option */
-        bufferPrintf(data->buffer, data->width, data->height, data->height, x, y, 0, "%s", data->list[i]);
-        
-        /* Post-option (border and/or selection arrows) */
-        if (data->bordered){
-            CursesChar* borderChar = &data->buffer[ ((data->width-1) * data->height) + y];
-            borderChar->character = L'│';
-        }
-        if (data->arrowSelection){
-            CursesChar* arrowChar = &data->buffer[ ((data->width-2) * data->height) + y];
-            // default selection is the first one
-            if (i==data->currentSelection){
-                arrowChar->character = L'♦';
-            } else {
-                arrowChar->character = L' ';
+            // draw the options that scrolled into view
+            for (int row = 0; row < data->visibleRows; row++){
+                int option = firstVisible + row;
+                if (option < oldFirstVisible || option >= oldFirstVisible + data->visibleRows){
+                    drawSelectionWindowRow(data, option);
+                }
+            }
+        } else {
+            for (int row = 0; row < data->visibleRows; row++){
+                drawSelectionWindowRow(data, firstVisible + row);
             }
         }
     }
 
+    /* Move the selection arrows */
+    // rows that aren't visible are skipped
+    drawSelectionWindowRow(data, previousSelection);
+    drawSelectionWindowRow(data, selection);
+}
+
+/* Helper functions */
+// Draws one option to its row in the buffer, if it's visible
+static void drawSelectionWindowRow(SelectionWindowData* data, int option){
+    int y = option - data->firstVisible;
+    if (y < 0 || y >= data->visibleRows){
+        return;
+    }
+    int right = data->bufferWidth - 1;
+    int x = (data->arrowSelection) ? 1 : 0;
+
+    /* Clear row */
+    // a row can be reused for a shorter option after scrolling
+    // if bordered, fill with spaces, else fill with transparent NBSP char
+    bufferFill(data->buffer, data->bufferWidth, 0, y, data->bufferWidth, 1, 0, (data->bordered) ? L' ' : L'\u00A0');
+
+    /* Print option */
+    bufferPutString(data->buffer, data->bufferWidth, data->bufferWidth, data->bufferHeight, x, y, 0, data->list[option]);
+
+    /* Selection arrows */
+    if (data->arrowSelection){
+        uint16_t arrow = getGlyph((option == data->currentSelection) ? L'♦' : L' ');
+        data->buffer[(y * data->bufferWidth) + 0].glyph = arrow;
+        data->buffer[(y * data->bufferWidth) + right].glyph = arrow;
+    }
 }
 
 /* SelectionWindow function implementations */
 void drawSelectionWindow(Object* self, CursesChar* buffer){
     SelectionWindowData* data = (SelectionWindowData*)((GameObject*)self)->userData;
 
-    /* Draw buffer */
-    for (int x = 0; x < data->width; x++){
-        for (int y = 0; y < data->height; y++){
-            CursesChar* bufferChar = &data->buffer[(data->height * x) + y];
-            // if char is not NBSP (\u00A0), draw it. (NBSP is transparent character for our case)
-            if (bufferChar->character != L'\u00A0'){
-                writecharToBuffer(buffer, x, y, bufferChar);
-            }
-        }
+    if (!data->bordered){
+        drawBufferToBuffer(buffer, data->buffer, data->bufferWidth, data->bufferHeight);
+        return;
+    }
+
+    /* Draw border, then the options inside it */
+    drawBorderToBuffer(buffer, data->border, data->height);
+    drawBufferToBuffer(&buffer[BUFFER_STRIDE + 1], data->buffer, data->bufferWidth, data->bufferHeight);
+
+    // scroll indicators go over the border, if there are options out of view
+    CursesChar indicator = {0, 0};
+    if (data->firstVisible > 0){
+        indicator.glyph = getGlyph(L'▲');
+        writecharToBuffer(buffer, data->width - 2, 0, &indicator);
+    }
+    if (data->firstVisible + data->visibleRows < data->numOptions){
+        indicator.glyph = getGlyph(L'▼');
+        writecharToBuffer(buffer, data->width - 2, data->height - 1, &indicator);
     }
 }
 
@@ -218,26 +255,20 @@ void selectionWindowHandleEvents(Object* self, Event* event){
             case KEY_UP:
                 // move selection up if current selection is not zero
                 if (data->currentSelection > 0){
-                    data->currentSelection--;
+                    setSelectionWindowSelection((GameObject*)self, data->currentSelection - 1);
                     if (data->selectionChangedCallback != NULL){
                         data->selectionChangedCallback(data->currentSelection);
                     }
                 }
-
-                // update buffer
-                drawSelectionWindowBuffer((GameObject*)self);
                 break;
             case KEY_DOWN:
                 // move selection down if current selection is not the last option
                 if (data->currentSelection < (data->numOptions - 1)){
-                    data->currentSelection++;
+                    setSelectionWindowSelection((GameObject*)self, data->currentSelection + 1);
                     if (data->selectionChangedCallback != NULL){
                         data->selectionChangedCallback(data->currentSelection);
                     }
                 }
-
-                // update buffer
-                drawSelectionWindowBuffer((GameObject*)self);
                 break;
             case KEY_ENTER:
             case 10:
@@ -250,10 +281,9 @@ void selectionWindowHandleEvents(Object* self, Event* event){
         }
     }
 
-    // check keys for ch
-    for (int i = 0; i < data->numOptions; i++){
-        if (ch == data->keys[i]){
-            data->callbacks[i](i);
-        }
+    // look up the option for ch
+    if (ch >= 0 && ch < 256 && data->hotkeys[ch] >= 0){
+        int option = data->hotkeys[ch];
+        data->callbacks[option](option);
     }
 }
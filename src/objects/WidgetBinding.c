@@ -0,0 +1,86 @@
+/*
+ * Created by Sean Bowers
+ * CS 2060 section 3, Spring 2018
+ * University of Colorado at Colorado Springs
+ *
+ * Licensed under the MIT License (see LICENSE.txt)
+ */
+/* Implementation of widget bindings (ui.h) */
+
+#include <objects/ui.h>
+#include <stdlib.h>
+#include <stdarg.h>
+
+/* Timer callback */
+static uint64_t updateBindingList(void* data, uint64_t frameTime);
+
+void createBindingList(BindingList* list){
+    list->bindings = NULL;
+    list->timer.scheduled = false;
+}
+
+void destroyBindingList(BindingList* list){
+    cancelTimer(&list->timer);
+
+    WidgetBinding* binding = list->bindings;
+    while (binding != NULL){
+        WidgetBinding* next = binding->next;
+        free(binding);
+        binding = next;
+    }
+    list->bindings = NULL;
+}
+
+void bindWidget(BindingList* list, pfn_BindingUpdate update, void* data, int numSources, ...){
+    WidgetBinding* binding = (WidgetBinding*) malloc(sizeof(WidgetBinding));
+    binding->update = update;
+    binding->data = data;
+    binding->numSources = (numSources < MAX_BINDING_SOURCES) ? numSources : MAX_BINDING_SOURCES;
+
+    /* Get sources */
+    va_list args;
+    va_start(args, numSources);
+    for (int source = 0; source < binding->numSources; source++){
+        binding->sources[source] = va_arg(args, FieldVersion*);
+        // start out of date, so the first check runs the update
+        binding->seenVersions[source] = atomicLoad(binding->sources[source]) - 1;
+    }
+    va_end(args);
+
+    /* Add to the front of the list */
+    binding->next = list->bindings;
+    list->bindings = binding;
+}
+
+void startBindingList(BindingList* list){
+    scheduleTimer(&list->timer, getTimems(), updateBindingList, list);
+}
+
+int updateBindings(BindingList* list){
+    int updated = 0;
+    for (WidgetBinding* binding = list->bindings; binding != NULL; binding = binding->next){
+        // read every version before updating, so changes made during the update are seen next time
+        bool changed = false;
+        for (int source = 0; source < binding->numSources; source++){
+            int version = atomicLoad(binding->sources[source]);
+            if (version != binding->seenVersions[source]){
+                binding->seenVersions[source] = version;
+                changed = true;
+            }
+        }
+
+        if (changed){
+            binding->update(binding->data);
+            updated++;
+        }
+    }
+    return updated;
+}
+
+// Checks the list once a frame
+static uint64_t updateBindingList(void* data, uint64_t frameTime){
+    updateBindings((BindingList*)data);
+
+    // run again on the next frame
+    return frameTime + 1;
+}
@@ -22,6 +22,7 @@ GameObject* createXPSprite(XPFile* texture, int xpos, int ypos, int z, Engine* e
     
     /* Base Object Properties */
     newObject->objectProperties.drawObject = XPSpriteDraw;
+    setDrawFunctionName(XPSpriteDraw, "XPSprite");
     newObject->objectProperties.handleEvent = NULL;
     newObject->objectProperties.next = NULL;
     newObject->objectProperties.previous = NULL;
@@ -45,12 +46,12 @@ GameObject* createXPSprite(XPFile* texture, int xpos, int ypos, int z, Engine* e
     data->textureData->textureBuffer = (CursesChar*) malloc(sizeof(CursesChar)*data->textureData->width*data->textureData->height);
 
     /* Initialize texture buffer with transparent cells */
-    for (int x = 0; x < data->textureData->width; x++){
-        for (int y = 0; y < data->textureData->height; y++){
-            CursesChar* backgroundChar = &data->textureData->textureBuffer[(data->textureData->height * x) + y];
-            backgroundChar->attributes = 0;
+    for (int y = 0; y < data->textureData->height; y++){
+        for (int x = 0; x < data->textureData->width; x++){
+            CursesChar* backgroundChar = &data->textureData->textureBuffer[(data->textureData->width * y) + x];
+            backgroundChar->style = 0;
             // transparent cell denoted by NBSP unicode character
-            backgroundChar->character = L'\u00A0';
+            backgroundChar->glyph = GLYPH_TRANSPARENT;
         }
     }
 
@@ -74,13 +75,5 @@ void XPSpriteDraw(Object* self, CursesChar* buffer){
     XPSpriteData* data = (XPSpriteData*)((GameObject*)self)->userData;
 
     /* Add chars from textureBuffer to buffer */
-    for (int x = 0; x < data->textureData->width; x++){
-        for (int y = 0; y < data->textureData->height; y++){
-            CursesChar* textureChar = &data->textureData->textureBuffer[(data->textureData->height * x) + y];
-            // if char is not NBSP (\u00A0), draw it. (NBSP is transparent character for our case)
-            if (textureChar->character != L'\u00A0'){
-                writecharToBuffer(buffer, x, y, textureChar);
-            }
-        }
-    }
+    drawBufferToBuffer(buffer, data->textureData->textureBuffer, data->textureData->width, data->textureData->height);
 }
@@ -32,6 +32,7 @@ Panel* createPanel(int width, int height, int x, int y, int z){
     newPanel->objectProperties.parent = NULL;
     newPanel->objectProperties.show = true;
     newPanel->objectProperties.drawObject = defaultDrawPanel;
+    setDrawFunctionName(defaultDrawPanel, "Panel");
     newPanel->objectProperties.handleEvent = defaultPanelHandleEvent;
 
     /* Assign function pointers */
@@ -50,14 +51,15 @@ Panel* createPanel(int width, int height, int x, int y, int z){
     newPanel->width = width;
     newPanel->height = height;
     newPanel->backgroundBuffer = (CursesChar*) malloc(sizeof(CursesChar)*width*height);
+    atomicAdd64(&bufferMemory, (int64_t)(sizeof(CursesChar) * width * height));
 
     /* Fill background buffer */
-    for (int x = 0; x < newPanel->width; x++){
-        for (int y = 0; y < newPanel->height; y++){
-            CursesChar* currentChar = &newPanel->backgroundBuffer[(newPanel->height * x) + y];
-            currentChar->attributes = 0;
+    for (int y = 0; y < newPanel->height; y++){
+        for (int x = 0; x < newPanel->width; x++){
+            CursesChar* currentChar = &newPanel->backgroundBuffer[(newPanel->width * y) + x];
+            currentChar->style = 0;
             // clear char array
-			currentChar->character = L'\u00A0';
+			currentChar->glyph = GLYPH_TRANSPARENT;
         }
     }
 
@@ -68,6 +70,7 @@ Panel* createPanel(int width, int height, int x, int y, int z){
 void destroyPanel(Panel* panel){
 	/* Free background buffer */
 	free(panel->backgroundBuffer);
+	atomicAdd64(&bufferMemory, -(int64_t)(sizeof(CursesChar) * panel->width * panel->height));
 
 	/* Free event listeners (see add listener function for details on what memory we own and need to free) */
 	EventListener* current = panel->listeners;
@@ -81,6 +84,39 @@ void destroyPanel(Panel* panel){
     free(panel);
 }
 
+void compileDrawList(Object* object, CursesChar* buffer, int x, int y, DrawList* list){
+    // panels using the default draw function are flattened into their background and children,
+    // any other object (or a panel with a custom draw function) is drawn as a single entry
+    bool flattenPanel = (object->type == OBJECT_PANEL) && (object->drawObject == defaultDrawPanel);
+
+    /* Make room for the new entry */
+    if (list->numEntries == list->maxEntries){
+        atomicAdd64(&bufferMemory, (int64_t)(sizeof(DrawListEntry) * ((list->maxEntries == 0)? 64 : list->maxEntries)));
+        list->maxEntries = (list->maxEntries == 0)? 64 : list->maxEntries * 2;
+        list->entries = (DrawListEntry*) realloc(list->entries, sizeof(DrawListEntry) * list->maxEntries);
+    }
+
+    /* Add entry */
+    DrawListEntry* entry = &list->entries[list->numEntries++];
+    entry->object = object;
+    entry->panelBackground = flattenPanel;
+    entry->x = x;
+    entry->y = y;
+    entry->buffer = buffer;
+
+    /* Add children in the same order defaultDrawPanel() would draw them */
+    if (flattenPanel){
+        Object* current = ((Panel*)object)->childrenList;
+        while (current != NULL){
+            if (current->show){
+                CursesChar* bufferAtObject = &buffer[(BUFFER_STRIDE * current->y) + current->x];
+                compileDrawList(current, bufferAtObject, x + current->x, y + current->y, list);
+            }
+            current = current->next;
+        }
+    }
+}
+
 /* default functions implementation */
 void defaultAddObject(Panel* self, Object* newObject){
     /* Set self as parent to newObject */
@@ -138,22 +174,14 @@ void defaultRemoveObject(Panel* self, Object* toRemove){
 
 void defaultDrawPanel(Object* self, CursesChar* buffer){
     /* Draw background buffer */
-    for (int x = 0; x < ((Panel*)self)->width; x++){
-        for (int y = 0; y < ((Panel*)self)->height; y++){
-            CursesChar* backgroundChar = &((Panel*)self)->backgroundBuffer[((((Panel*)self)->height) * x) + y];
-            // if background char is not NBSP (\u00A0), draw it. (NBSP is transparent character for our case)
-            if (backgroundChar->character != L'\u00A0'){
-                writecharToBuffer(buffer, x, y, backgroundChar);
-            }
-        }
-    }
+    drawBufferToBuffer(buffer, ((Panel*)self)->backgroundBuffer, ((Panel*)self)->width, ((Panel*)self)->height);
 
     /* Crawl list of objects, drawing each */
     Object* current = ((Panel*)self)->childrenList;
     while (current != NULL){
         if (current->show){
             // get the offset into buffer at the x,y position of the object
-            CursesChar* bufferAtObject = &buffer[(LINES * current->x) + current->y];
+            CursesChar* bufferAtObject = &buffer[(BUFFER_STRIDE * current->y) + current->x];
             // draw the object at it's location
             current->drawObject(current, bufferAtObject);
         }
@@ -0,0 +1,311 @@
+/*
+ * Created by Sean Bowers
+ * CS 2060 section 3, Spring 2018
+ * University of Colorado at Colorado Springs
+ *
+ * Licensed under the MIT License (see LICENSE.txt)
+ */
+/* Lock profiling for threads.h (only built with PROFILE_LOCKS) */
+
+// use the real lock macros in this file
+#define __THREADS_C__
+#include <engine.h>
+
+#ifdef PROFILE_LOCKS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// most locks, conditions, and barriers that can be profiled (anything past this isn't counted)
+#define MAX_PROFILED_OBJECTS 256
+// wait times are counted in powers of two nanoseconds, up to ~2 minutes
+#define PROFILE_HISTOGRAM_BUCKETS 37
+
+typedef enum ProfiledObjectType_e{
+    PROFILED_LOCK,
+    PROFILED_CONDITION,
+    PROFILED_BARRIER
+} ProfiledObjectType;
+
+static const char* profiledObjectTypeNames[] = {"lock", "condition", "barrier"};
+
+typedef struct LockProfile_s{
+    const void* volatile object; // set last, once the rest of the entry is filled in
+    char name[64];
+    ProfiledObjectType type;
+
+    // counted with atomics, since any thread can update them
+    volatile uint64_t acquisitions; // times locked, waited on, or entered
+    volatile uint64_t contended; // locks that were already held when they were asked for
+    volatile uint64_t totalWait, maxWait; // ns
+    volatile uint64_t totalHold, maxHold; // ns, locks only
+    volatile uint64_t waitHistogram[PROFILE_HISTOGRAM_BUCKETS];
+
+    // when the lock was last acquired (only touched by the thread holding it)
+    uint64_t acquiredTime;
+} LockProfile;
+
+// open addressed by the object's address
+static LockProfile lockProfiles[MAX_PROFILED_OBJECTS];
+// held while an entry is being added (a spin lock, since it can't be a profiled lock)
+static volatile int lockProfilesLock = 0;
+static volatile int numLockProfiles = 0;
+
+/* Atomics on 64 bit counters */
+#ifdef __UNIX__
+#define profileAdd(value, amount)\
+    __atomic_add_fetch(value, amount, __ATOMIC_RELAXED)
+
+#define profileLoadObject(object)\
+    __atomic_load_n(object, __ATOMIC_ACQUIRE)
+
+#define profileStoreObject(object, newObject)\
+    __atomic_store_n(object, newObject, __ATOMIC_RELEASE)
+
+#define tryLockThreadLock(lock)\
+    (pthread_mutex_trylock(lock) == 0)
+#elif __WIN32__
+#define profileAdd(value, amount)\
+    InterlockedExchangeAdd64((volatile LONG64*)(value), amount)
+
+#define profileLoadObject(object)\
+    InterlockedCompareExchangePointer((PVOID volatile*)(object), NULL, NULL)
+
+#define profileStoreObject(object, newObject)\
+    InterlockedExchangePointer((PVOID volatile*)(object), (PVOID)(newObject))
+
+#define tryLockThreadLock(lock)\
+    TryEnterCriticalSection(lock)
+#endif
+
+static void profileMax(volatile uint64_t* value, uint64_t newValue){
+    #ifdef __UNIX__
+    uint64_t current = __atomic_load_n(value, __ATOMIC_RELAXED);
+    while (newValue > current && !__atomic_compare_exchange_n(value, &current, newValue, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+        // current is updated by the failed exchange
+    }
+    #elif __WIN32__
+    uint64_t current = *value;
+    while (newValue > current){
+        uint64_t previous = InterlockedCompareExchange64((volatile LONG64*)value, newValue, current);
+        if (previous == current){
+            break;
+        }
+        current = previous;
+    }
+    #endif
+}
+
+/* Entries */
+// Names an entry after the expression used to get to the object, without the & or the pointer it was reached through
+static void setLockProfileName(LockProfile* profile, const char* expression){
+    if (*expression == '&'){
+        expression++;
+    }
+    const char* arrow = strstr(expression, "->");
+    if (arrow != NULL){
+        expression = arrow + 2;
+    }
+    snprintf(profile->name, sizeof(profile->name), "%s", expression);
+}
+
+// Finds the entry for an object, adding it if it's new (returns NULL if there's no room for it)
+static LockProfile* getLockProfile(const void* object, const char* name, ProfiledObjectType type){
+    unsigned int start = (unsigned int)(((uintptr_t)object >> 3) * 2654435761u) % MAX_PROFILED_OBJECTS;
+
+    // look for the object without locking, entries are never removed
+    for (int i = 0; i < MAX_PROFILED_OBJECTS; i++){
+        LockProfile* profile = &lockProfiles[(start + i) % MAX_PROFILED_OBJECTS];
+        const void* entryObject = profileLoadObject(&profile->object);
+        if (entryObject == object){
+            return profile;
+        } else if (entryObject == NULL){
+            break;
+        }
+    }
+
+    /* Add the object */
+    while (atomicExchange(&lockProfilesLock, 1)){
+        yieldThread();
+    }
+    LockProfile* found = NULL;
+    for (int i = 0; i < MAX_PROFILED_OBJECTS; i++){
+        LockProfile* profile = &lockProfiles[(start + i) % MAX_PROFILED_OBJECTS];
+        if (profile->object == object){
+            // another thread added it first
+            found = profile;
+            break;
+        } else if (profile->object == NULL){
+            setLockProfileName(profile, name);
+            // objects reached the same way (ex. the startBarrier of each worker pool) are numbered
+            size_t length = strlen(profile->name);
+            int sameName = 0;
+            for (int j = 0; j < MAX_PROFILED_OBJECTS; j++){
+                LockProfile* other = &lockProfiles[j];
+                if (other->object != NULL && strncmp(other->name, profile->name, length) == 0 && (other->name[length] == '\0' || other->name[length] == ' ')){
+                    sameName++;
+                }
+            }
+            if (sameName > 0){
+                snprintf(&profile->name[length], sizeof(profile->name) - length, " #%d", sameName + 1);
+            }
+            profile->type = type;
+            profileStoreObject(&profile->object, object);
+            found = profile;
+            // print the report when the program exits, once there's something to report
+            if (atomicIncrement(&numLockProfiles) == 1){
+                atexit(printLockProfile);
+            }
+            break;
+        }
+    }
+    atomicStore(&lockProfilesLock, 0);
+    return found;
+}
+
+static void recordWait(LockProfile* profile, uint64_t wait){
+    profileAdd(&profile->acquisitions, 1);
+    profileAdd(&profile->totalWait, wait);
+    profileMax(&profile->maxWait, wait);
+
+    int bucket = 0;
+    while (bucket < PROFILE_HISTOGRAM_BUCKETS - 1 && (wait >> (bucket + 1)) != 0){
+        bucket++;
+    }
+    profileAdd(&profile->waitHistogram[bucket], 1);
+}
+
+static void recordHold(LockProfile* profile, uint64_t now){
+    uint64_t hold = now - profile->acquiredTime;
+    profileAdd(&profile->totalHold, hold);
+    profileMax(&profile->maxHold, hold);
+}
+
+/* Profiled macros */
+void profileCreateLock(ThreadLock_t* lock, const char* name){
+    createLock(lock);
+    getLockProfile(lock, name, PROFILED_LOCK);
+}
+
+void profileCreateBarrier(ThreadBarrier_t* barrier, int numThreads, const char* name){
+    createBarrier(barrier, numThreads);
+    getLockProfile(barrier, name, PROFILED_BARRIER);
+}
+
+void profileLockThreadLock(ThreadLock_t* lock, const char* name){
+    LockProfile* profile = getLockProfile(lock, name, PROFILED_LOCK);
+    uint64_t start = getTimens();
+
+    // only locks that are already held count as contended
+    if (!tryLockThreadLock(lock)){
+        lockThreadLock(lock);
+        if (profile != NULL){
+            profileAdd(&profile->contended, 1);
+        }
+    }
+
+    uint64_t now = getTimens();
+    if (profile != NULL){
+        recordWait(profile, now - start);
+        profile->acquiredTime = now;
+    }
+}
+
+void profileUnlockThreadLock(ThreadLock_t* lock){
+    // the lock was added when it was locked, so the name isn't needed
+    LockProfile* profile = getLockProfile(lock, "(unknown)", PROFILED_LOCK);
+    if (profile != NULL){
+        recordHold(profile, getTimens());
+    }
+    unlockThreadLock(lock);
+}
+
+void profileWaitForConditionSignal(ThreadCondition_t* condition, const char* conditionName, ThreadLock_t* lock, const char* lockName){
+    LockProfile* conditionProfile = getLockProfile(condition, conditionName, PROFILED_CONDITION);
+    LockProfile* lockProfile = getLockProfile(lock, lockName, PROFILED_LOCK);
+
+    // the lock isn't held while waiting, so the hold ends here and starts again once the wait is over
+    uint64_t start = getTimens();
+    if (lockProfile != NULL){
+        recordHold(lockProfile, start);
+    }
+
+    waitForConditionSignal(condition, lock);
+
+    uint64_t now = getTimens();
+    if (conditionProfile != NULL){
+        recordWait(conditionProfile, now - start);
+    }
+    if (lockProfile != NULL){
+        lockProfile->acquiredTime = now;
+    }
+}
+
+void profileEnterThreadBarrier(ThreadBarrier_t* barrier, const char* name){
+    LockProfile* profile = getLockProfile(barrier, name, PROFILED_BARRIER);
+    uint64_t start = getTimens();
+    enterThreadBarrier(barrier);
+    if (profile != NULL){
+        recordWait(profile, getTimens() - start);
+    }
+}
+
+/* Report */
+// Upper bound (ns) of the histogram bucket the given percentile of waits fell in (or the longest wait, if that's less)
+static uint64_t getWaitPercentile(LockProfile* profile, double percentile){
+    uint64_t target = (uint64_t)(profile->acquisitions * percentile);
+    uint64_t count = 0;
+    for (int bucket = 0; bucket < PROFILE_HISTOGRAM_BUCKETS; bucket++){
+        count += profile->waitHistogram[bucket];
+        if (count > target){
+            uint64_t bucketEnd = (uint64_t)2 << bucket;
+            return (bucketEnd < profile->maxWait)? bucketEnd : profile->maxWait;
+        }
+    }
+    return profile->maxWait;
+}
+
+static int compareLockProfiles(const void* a, const void* b){
+    const LockProfile* profileA = *(const LockProfile**)a;
+    const LockProfile* profileB = *(const LockProfile**)b;
+    if (profileA->totalWait == profileB->totalWait){
+        return 0;
+    }
+    return (profileA->totalWait < profileB->totalWait)? 1 : -1;
+}
+
+void printLockProfile(){
+    /* Rank everything that was used by total wait */
+    LockProfile* ranked[MAX_PROFILED_OBJECTS];
+    int numRanked = 0;
+    for (int i = 0; i < MAX_PROFILED_OBJECTS; i++){
+        if (profileLoadObject(&lockProfiles[i].object) != NULL && lockProfiles[i].acquisitions > 0){
+            ranked[numRanked++] = &lockProfiles[i];
+        }
+    }
+    qsort(ranked, numRanked, sizeof(LockProfile*), compareLockProfiles);
+
+    /* Print */
+    // times in microseconds, except total wait (ms). p50/p99 are the upper bounds of their histogram buckets
+    printf("Lock contention, ranked by total wait (times in us):\n");
+    printf("%-36s %-9s %10s %10s %13s %10s %10s %10s %10s %10s %10s\n", "name", "type", "count", "contended",
+            "wait total ms", "wait mean", "wait p50", "wait p99", "wait max", "hold mean", "hold max");
+    for (int i = 0; i < numRanked; i++){
+        LockProfile* profile = ranked[i];
+        double count = (double)profile->acquisitions;
+        printf("%-36s %-9s %10llu ", profile->name, profiledObjectTypeNames[profile->type], (unsigned long long)profile->acquisitions);
+        if (profile->type == PROFILED_LOCK){
+            printf("%9.1f%% ", 100.0 * profile->contended / count);
+        } else {
+            printf("%10s ", "-");
+        }
+        printf("%13.2f %10.2f %10.2f %10.2f %10.2f ", profile->totalWait / 1000000.0, profile->totalWait / count / 1000.0,
+                getWaitPercentile(profile, 0.50) / 1000.0, getWaitPercentile(profile, 0.99) / 1000.0, profile->maxWait / 1000.0);
+        if (profile->type == PROFILED_LOCK){
+            printf("%10.2f %10.2f\n", profile->totalHold / count / 1000.0, profile->maxHold / 1000.0);
+        } else {
+            printf("%10s %10s\n", "-", "-");
+        }
+    }
+}
+#endif // PROFILE_LOCKS
@@ -0,0 +1,276 @@
+/*
+ * Created by Sean Bowers
+ * CS 2060 section 3, Spring 2018
+ * University of Colorado at Colorado Springs
+ *
+ * Licensed under the MIT License (see LICENSE.txt)
+ */
+/* Implementation of the trace recorder (trace.h) */
+
+#include <trace.h>
+#include <engine.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+
+#define DEFAULT_TRACE_EVENTS (1 << 15)
+
+/* Rings */
+typedef struct TraceEvent_s{
+    uint64_t time; // getTimens()
+    const char* name; // NULL for the end of a span
+    char detail[TRACE_DETAIL_LENGTH];
+} TraceEvent;
+
+typedef struct TraceBuffer_s{
+    TraceEvent* events;
+    // events written to this ring so far, the next goes at written & (traceCapacity - 1)
+    // (counts up forever, wrapping around as an unsigned int, so readers can tell if what they copied was overwritten)
+    volatile int written;
+    volatile int full;
+    int threadID;
+    char threadName[32];
+    struct TraceBuffer_s* next;
+} TraceBuffer;
+
+bool traceEnabled = false;
+
+static char* tracePath = NULL;
+static uint64_t traceStartTime;
+static unsigned int traceCapacity;
+
+// every ring, so they can be written out (protected by traceLock, only changed when a thread records its first event)
+static ThreadLock_t traceLock;
+static TraceBuffer* traceBuffers = NULL;
+static int nextThreadID = 1;
+
+static THREAD_LOCAL TraceBuffer* threadTraceBuffer = NULL;
+
+static TraceBuffer* getThreadTraceBuffer();
+static int copyTraceEvents(TraceBuffer* buffer, TraceEvent* events);
+static void writeTraceString(FILE* file, const char* string);
+
+/* Signals */
+static volatile sig_atomic_t snapshotRequested = 0;
+static volatile sig_atomic_t exitRequested = 0;
+static void handleTraceSignal(int signal);
+
+bool startTrace(const char* path, int eventsPerThread){
+    if (traceEnabled){
+        return false;
+    }
+
+    // the ring size is a power of two, so wrapping the index is a mask
+    traceCapacity = 1;
+    unsigned int requested = (eventsPerThread > 0)? (unsigned int)eventsPerThread : DEFAULT_TRACE_EVENTS;
+    while (traceCapacity < requested){
+        traceCapacity *= 2;
+    }
+
+    tracePath = (char*) malloc(strlen(path) + 1);
+    strcpy(tracePath, path);
+    createLock(&traceLock);
+    traceStartTime = getTimens();
+
+    /* Catch signals asking for the trace */
+    #ifdef __UNIX__
+    signal(SIGUSR1, handleTraceSignal);
+    #endif
+    signal(SIGINT, handleTraceSignal);
+    signal(SIGTERM, handleTraceSignal);
+
+    traceEnabled = true;
+    return true;
+}
+
+void stopTrace(){
+    if (!traceEnabled){
+        return;
+    }
+    traceEnabled = false;
+
+    TraceBuffer* buffer = traceBuffers;
+    while (buffer != NULL){
+        TraceBuffer* next = buffer->next;
+        free(buffer->events);
+        free(buffer);
+        buffer = next;
+    }
+    traceBuffers = NULL;
+    threadTraceBuffer = NULL;
+    free(tracePath);
+    tracePath = NULL;
+}
+
+void nameTraceThread(const char* name){
+    if (!traceEnabled){
+        return;
+    }
+    TraceBuffer* buffer = getThreadTraceBuffer();
+    lockThreadLock(&traceLock);
+    snprintf(buffer->threadName, sizeof(buffer->threadName), "%s", name);
+    unlockThreadLock(&traceLock);
+}
+
+void recordTraceEvent(const char* name, const char* detail){
+    TraceBuffer* buffer = getThreadTraceBuffer();
+
+    // only this thread writes to the ring, so the count can be read without an atomic
+    unsigned int written = (unsigned int)buffer->written;
+    TraceEvent* event = &buffer->events[written & (traceCapacity - 1)];
+    event->time = getTimens();
+    event->name = name;
+    if (detail != NULL){
+        snprintf(event->detail, TRACE_DETAIL_LENGTH, "%s", detail);
+    } else {
+        event->detail[0] = '\0';
+    }
+
+    // publish the event (readers check the count again after copying, in case it was overwritten)
+    if (written + 1 == traceCapacity){
+        atomicStore(&buffer->full, 1);
+    }
+    atomicStore(&buffer->written, (int)(written + 1));
+}
+
+// Gets the ring for this thread, making it the first time
+static TraceBuffer* getThreadTraceBuffer(){
+    if (threadTraceBuffer == NULL){
+        TraceBuffer* buffer = (TraceBuffer*) malloc(sizeof(TraceBuffer));
+        buffer->events = (TraceEvent*) malloc(sizeof(TraceEvent) * traceCapacity);
+        buffer->written = 0;
+        buffer->full = 0;
+
+        lockThreadLock(&traceLock);
+        buffer->threadID = nextThreadID++;
+        snprintf(buffer->threadName, sizeof(buffer->threadName), "thread %d", buffer->threadID);
+        buffer->next = traceBuffers;
+        traceBuffers = buffer;
+        unlockThreadLock(&traceLock);
+
+        threadTraceBuffer = buffer;
+    }
+    return threadTraceBuffer;
+}
+
+/* Writing */
+bool writeTrace(){
+    if (!traceEnabled){
+        return false;
+    }
+
+    FILE* file = fopen(tracePath, "w");
+    if (file == NULL){
+        return false;
+    }
+
+    // one ring is copied at a time, so threads can keep recording while it's written
+    TraceEvent* events = (TraceEvent*) malloc(sizeof(TraceEvent) * traceCapacity);
+    fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    fprintf(file, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"Alcubierre\"}}");
+
+    lockThreadLock(&traceLock);
+    for (TraceBuffer* buffer = traceBuffers; buffer != NULL; buffer = buffer->next){
+        fprintf(file, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": ", buffer->threadID);
+        writeTraceString(file, buffer->threadName);
+        fprintf(file, "}}");
+        fprintf(file, ",\n{\"name\": \"thread_sort_index\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"sort_index\": %d}}",
+                buffer->threadID, buffer->threadID);
+
+        int numEvents = copyTraceEvents(buffer, events);
+        // the ring may have wrapped around in the middle of a span, so skip ends that have lost their begin
+        int depth = 0;
+        for (int i = 0; i < numEvents; i++){
+            TraceEvent* event = &events[i];
+            double timestamp = (event->time - traceStartTime) / 1000.0;
+            if (event->name == NULL){
+                if (depth == 0){
+                    continue;
+                }
+                depth--;
+                fprintf(file, ",\n{\"ph\": \"E\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f}", buffer->threadID, timestamp);
+            } else {
+                depth++;
+                fprintf(file, ",\n{\"name\": ");
+                writeTraceString(file, event->name);
+                fprintf(file, ", \"ph\": \"B\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f", buffer->threadID, timestamp);
+                if (event->detail[0] != '\0'){
+                    fprintf(file, ", \"args\": {\"detail\": ");
+                    writeTraceString(file, event->detail);
+                    fprintf(file, "}");
+                }
+                fprintf(file, "}");
+            }
+        }
+    }
+    unlockThreadLock(&traceLock);
+
+    fprintf(file, "\n]}\n");
+    free(events);
+    bool written = (ferror(file) == 0);
+    fclose(file);
+    return written;
+}
+
+// Copies a ring's events (oldest first) into events, leaving out any that were overwritten while copying
+static int copyTraceEvents(TraceBuffer* buffer, TraceEvent* events){
+    unsigned int before = (unsigned int)atomicLoad(&buffer->written);
+    bool wrapped = atomicLoad(&buffer->full);
+    unsigned int count = (wrapped)? traceCapacity : before;
+    unsigned int first = before - count;
+    for (unsigned int i = 0; i < count; i++){
+        events[i] = buffer->events[(first + i) & (traceCapacity - 1)];
+    }
+
+    // events written since we started go after the newest one, so they only overwrite the oldest once the ring
+    // is full (before then they go into empty slots, and only the ones past the end wrap around onto ours)
+    unsigned int writtenSince = (unsigned int)atomicLoad(&buffer->written) - before;
+    unsigned int overwritten;
+    if (wrapped){
+        overwritten = writtenSince;
+    } else {
+        overwritten = (before + writtenSince > traceCapacity)? before + writtenSince - traceCapacity : 0;
+    }
+    if (overwritten >= count){
+        return 0;
+    }
+    if (overwritten > 0){
+        memmove(events, &events[overwritten], sizeof(TraceEvent) * (count - overwritten));
+    }
+    return (int)(count - overwritten);
+}
+
+static void writeTraceString(FILE* file, const char* string){
+    fputc('"', file);
+    for (const char* c = string; *c != '\0'; c++){
+        if (*c == '"' || *c == '\\'){
+            fputc('\\', file);
+            fputc(*c, file);
+        } else if ((unsigned char)*c < 0x20){
+            fprintf(file, "\\u%04x", (unsigned char)*c);
+        } else {
+            fputc(*c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+/* Signals */
+static void handleTraceSignal(int signalNumber){
+    #ifdef __UNIX__
+    if (signalNumber == SIGUSR1){
+        snapshotRequested = 1;
+        return;
+    }
+    #endif
+    exitRequested = 1;
+}
+
+bool pollTraceSignals(){
+    if (snapshotRequested){
+        snapshotRequested = 0;
+        writeTrace();
+    }
+    return exitRequested;
+}
@@ -240,10 +240,13 @@ wchar_t getUTF8CharForCP437Value(int value){
 
 /* Draw function */
 void drawLayerToBuffer(XPLayer* layer, CursesChar* buffer, bool transparent, Engine* engine){
+    TRACE_BEGIN("drawLayerToBuffer");
+
     /* Draw to buffer */
-    for (int x = 0; x < layer->width; x++){
-        for (int y = 0; y < layer->height; y++){
-            int index = (layer->height * x) + y;
+    // both the layer and buffer are row major, and the same size
+    for (int y = 0; y < layer->height; y++){
+        for (int x = 0; x < layer->width; x++){
+            int index = (layer->width * y) + x;
             CursesChar* charAt = &buffer[index];
 
             /* Get char data */
@@ -255,8 +258,8 @@ void drawLayerToBuffer(XPLayer* layer, CursesChar* buffer, bool transparent, Eng
             int fg = getBestColor(xpChar->fr, xpChar->fg, xpChar->fb, engine);
             int colorPair = getColorPair(fg, bg, engine);
             CursesChar cursesChar;
-            cursesChar.attributes = COLOR_PAIR(colorPair);
-            cursesChar.character = wch;
+            cursesChar.style = getCellStyle(COLOR_PAIR(colorPair));
+            cursesChar.glyph = getGlyph(wch);
             //wadd_wch(win, &cursesChar);
             if ((xpChar->br == 255 && xpChar->bg == 0 && xpChar->bb == 255)
                 || (xpChar->value == 0)){
@@ -265,8 +268,8 @@ void drawLayerToBuffer(XPLayer* layer, CursesChar* buffer, bool transparent, Eng
                     // don't overwrite chars below us, so do nothing
                 } else {
                     // write transparent char
-                    charAt->attributes = 0;
-                    charAt->character = L'\u00A0';
+                    charAt->style = 0;
+                    charAt->glyph = GLYPH_TRANSPARENT;
                 }
             } else {
                 // copy char data to the buffer
@@ -274,4 +277,6 @@ void drawLayerToBuffer(XPLayer* layer, CursesChar* buffer, bool transparent, Eng
             }
         }
     }
+
+    TRACE_END();
 }
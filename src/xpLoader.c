@@ -11,6 +11,23 @@
 #include <stdlib.h>
 #include <zlib.h>
 
+/* .xp files store each layer in column major order, but the engine's buffers are
+ * row major. Transposing once here means every later pass over the layer (drawing
+ * it to a buffer) can walk memory in order.
+ */
+static void transposeLayerToRowMajor(XPLayer* layer){
+    XPChar* rowMajor = (XPChar*) malloc(sizeof(XPChar) * layer->width * layer->height);
+
+    for (int x = 0; x < layer->width; x++){
+        for (int y = 0; y < layer->height; y++){
+            rowMajor[(layer->width * y) + x] = layer->data[(layer->height * x) + y];
+        }
+    }
+
+    free(layer->data);
+    layer->data = rowMajor;
+}
+
 XPFile* getXPFile_gz(gzFile* rawFile){
     XPFile* newFile = (XPFile*) malloc(sizeof(XPFile));
     int status;
@@ -99,6 +116,9 @@ XPFile* getXPFile_gz(gzFile* rawFile){
                 free(newFile);
                 return NULL;
             }
+
+            // store the layer row major, to match the engine's buffers
+            transposeLayerToRowMajor(thisLayer);
         }
     }else{
         // free allocated memory and return null
@@ -111,8 +131,18 @@ XPFile* getXPFile_gz(gzFile* rawFile){
 }
 
 XPFile* getXPFile(const char* filename){
+    TRACE_BEGIN_DETAIL("getXPFile", filename);
     gzFile rawFile = gzopen(filename, "rb");
-    return getXPFile_gz(&rawFile);
+    if (rawFile == NULL){
+        printf("Unable to open %s\n", filename);
+        TRACE_END();
+        return NULL;
+    }
+
+    XPFile* file = getXPFile_gz(&rawFile);
+    gzclose(rawFile);
+    TRACE_END();
+    return file;
 }
 
 void freeXPFile(XPFile* file){